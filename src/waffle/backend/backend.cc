@@ -33,6 +33,8 @@ Backend::Backend(wl_display* wl_display,
 #endif
   backend_window_->CreateRenderSurface(view_properties.width,
                                        view_properties.height);
+  backend_window_->GetFrameClock().SetRepaintDeadline(
+      std::chrono::milliseconds(view_properties.repaint_deadline_ms));
 }
 
 Backend::~Backend() {
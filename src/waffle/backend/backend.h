@@ -6,6 +6,7 @@
 #define WAFFLE_BACKEND_BACKEND_H_
 
 #include <memory>
+#include <vector>
 
 #include "waffle/backend/window/waffle_window.h"
 #include "waffle/backend/window/window_binding_handler.h"
@@ -22,6 +23,16 @@ class Backend {
     backend_window_->LoadIntoTexture(buffer, texture);
   }
 
+  std::vector<DmabufFormat> QueryDmabufFormats() const {
+    return backend_window_->QueryDmabufFormats();
+  }
+
+  bool LoadDmabufIntoTexture(wl_resource* buffer,
+                             const DmabufAttributes& attributes,
+                             Texture& texture) const {
+    return backend_window_->LoadDmabufIntoTexture(buffer, attributes, texture);
+  }
+
   bool IsValid() const { return backend_window_->IsValid(); }
 
   bool DispatchEvent() const { return backend_window_->DispatchEvent(); }
@@ -30,8 +41,27 @@ class Backend {
 
   void SwapBuffer();
 
+  // Shows a client's dmabuf buffer on the display instead of the composited
+  // frame. Returns false if it's not possible.
+  bool ScanoutBuffer(wl_resource* buffer,
+                     const DmabufAttributes& attributes) const {
+    return backend_window_->ScanoutBuffer(buffer, attributes);
+  }
+
+  bool IsFramePending() const { return backend_window_->IsFramePending(); }
+
+  int GetBufferAge() const {
+    return backend_window_->GetRenderSurfaceTarget()->GetBufferAge();
+  }
+
+  WafflePhysicalWindowBounds GetPhysicalWindowBounds() const {
+    return backend_window_->GetPhysicalWindowBounds();
+  }
+
   int32_t GetFrameRate() const { return backend_window_->GetFrameRate(); }
 
+  FrameClock& GetFrameClock() const { return backend_window_->GetFrameClock(); }
+
  private:
   std::unique_ptr<WaffleWindow> backend_window_;
 };
@@ -5,11 +5,76 @@
 
 #include "waffle/backend/surface/context_egl.h"
 
+#include <wayland-server.h>
+
+#include <algorithm>
+#include <cstring>
+
 #include "waffle/backend/surface/egl_utils.h"
 #include "waffle/logger.h"
 
 namespace waffle {
 
+namespace {
+
+constexpr uint32_t kDrmFormatR8 = 0x20203852;        // 'R8  '
+constexpr uint32_t kDrmFormatGR88 = 0x38385247;      // 'GR88'
+constexpr uint32_t kDrmFormatARGB8888 = 0x34325241;  // 'AR24'
+
+// A plane of a YUV dmabuf which is imported as an RGB image of its own.
+struct PlaneImport {
+  uint32_t format;
+  // The index of the dmabuf plane. Packed formats use the same plane for
+  // multiple views.
+  int plane;
+  int horizontal_subsampling;
+  int vertical_subsampling;
+};
+
+// How a YUV dmabuf is imported plane by plane. The planes are in the order
+// which the shader variant of |texture_format| samples them.
+struct YuvImport {
+  uint32_t format;
+  TextureFormat texture_format;
+  int num_planes;
+  PlaneImport planes[kTextureMaxPlanes];
+};
+
+constexpr YuvImport kYuvImports[] = {
+    // NV12: Y and interleaved UV.
+    {0x3231564e, TextureFormat::kNV12, 2,
+     {{kDrmFormatR8, 0, 1, 1}, {kDrmFormatGR88, 1, 2, 2}}},
+    // YUV420: Y, U and V.
+    {0x32315559, TextureFormat::kI420, 3,
+     {{kDrmFormatR8, 0, 1, 1},
+      {kDrmFormatR8, 1, 2, 2},
+      {kDrmFormatR8, 2, 2, 2}}},
+    // YUYV: Y0 and Y1 are the R of GR88, and U and V are the G and A of
+    // ARGB8888.
+    {0x56595559, TextureFormat::kYUYV, 2,
+     {{kDrmFormatGR88, 0, 1, 1}, {kDrmFormatARGB8888, 0, 2, 1}}},
+};
+
+const YuvImport* FindYuvImport(uint32_t format) {
+  for (const auto& yuv_import : kYuvImports) {
+    if (yuv_import.format == format) {
+      return &yuv_import;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+struct ContextEgl::BufferImage {
+  ContextEgl* context;
+  wl_resource* buffer;
+  // One image per plane if the planes are imported separately.
+  std::vector<EGLImageKHR> images;
+  Texture texture;
+  wl_listener destroy_listener;
+};
+
 ContextEgl::ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
                        EGLint egl_surface_type)
     : environment_(std::move(environment)), config_(nullptr) {
@@ -61,6 +126,8 @@ ContextEgl::ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
   {
     eglCreateImageKHR_ = reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(
         eglGetProcAddress("eglCreateImageKHR"));
+    eglDestroyImageKHR_ = reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(
+        eglGetProcAddress("eglDestroyImageKHR"));
     eglBindWaylandDisplayWL_ = reinterpret_cast<PFNEGLBINDWAYLANDDISPLAYWL>(
         eglGetProcAddress("eglBindWaylandDisplayWL"));
     eglUnbindWaylandDisplayWL_ = reinterpret_cast<PFNEGLUNBINDWAYLANDDISPLAYWL>(
@@ -68,7 +135,8 @@ ContextEgl::ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
     eglQueryWaylandBufferWL_ = reinterpret_cast<PFNEGLQUERYWAYLANDBUFFERWL>(
         eglGetProcAddress("eglQueryWaylandBufferWL"));
 
-    if (!eglCreateImageKHR_ || !eglBindWaylandDisplayWL_ ||
+    if (!eglCreateImageKHR_ || !eglDestroyImageKHR_ ||
+        !eglBindWaylandDisplayWL_ ||
         !eglUnbindWaylandDisplayWL_ || !eglQueryWaylandBufferWL_) {
       WAFFLE_LOG(ERROR) << "Failed to load all needed egl extension functions";
       return;
@@ -76,6 +144,30 @@ ContextEgl::ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
 
     valid_ = true;
   }
+
+  {
+    auto* extensions =
+        eglQueryString(environment_->Display(), EGL_EXTENSIONS);
+    dmabuf_import_supported_ =
+        extensions && strstr(extensions, "EGL_EXT_image_dma_buf_import");
+    if (extensions &&
+        strstr(extensions, "EGL_EXT_image_dma_buf_import_modifiers")) {
+      eglQueryDmaBufFormatsEXT_ =
+          reinterpret_cast<PFNEGLQUERYDMABUFFORMATSEXTPROC>(
+              eglGetProcAddress("eglQueryDmaBufFormatsEXT"));
+      eglQueryDmaBufModifiersEXT_ =
+          reinterpret_cast<PFNEGLQUERYDMABUFMODIFIERSEXTPROC>(
+              eglGetProcAddress("eglQueryDmaBufModifiersEXT"));
+      dmabuf_modifiers_supported_ =
+          eglQueryDmaBufFormatsEXT_ && eglQueryDmaBufModifiersEXT_;
+    }
+  }
+}
+
+ContextEgl::~ContextEgl() {
+  while (!buffer_images_.empty()) {
+    DestroyBufferImage(buffer_images_.begin()->second.get());
+  }
 }
 
 std::unique_ptr<LinuxEGLSurface> ContextEgl::CreateOnscreenSurface(
@@ -172,6 +264,12 @@ bool ContextEgl::UnbindWlDisplay(wl_display* display) {
 }
 
 void ContextEgl::LoadIntoTexture(wl_resource* buffer, Texture& texture) {
+  auto it = buffer_images_.find(buffer);
+  if (it != buffer_images_.end()) {
+    texture = it->second->texture;
+    return;
+  }
+
   EGLint width, height;
   eglQueryWaylandBufferWL_(environment_->Display(), buffer, EGL_WIDTH, &width);
   eglQueryWaylandBufferWL_(environment_->Display(), buffer, EGL_HEIGHT,
@@ -181,7 +279,286 @@ void ContextEgl::LoadIntoTexture(wl_resource* buffer, Texture& texture) {
   EGLImageKHR eglImageKhr =
       eglCreateImageKHR_(environment_->Display(), context_,
                          EGL_WAYLAND_BUFFER_WL, buffer, &attribs);
-  texture.LoadEGLImage((EGLImage)eglImageKhr, width, height);
+  if (eglImageKhr == EGL_NO_IMAGE_KHR) {
+    WAFFLE_LOG(ERROR) << "Failed to create EGLImage: "
+                      << get_egl_error_cause();
+    return;
+  }
+  auto& cached = CacheBufferImage(buffer, {eglImageKhr});
+  cached.LoadEGLImage((EGLImage)eglImageKhr, width, height);
+  texture = cached;
+}
+
+std::vector<DmabufFormat> ContextEgl::QueryDmabufFormats() const {
+  std::vector<DmabufFormat> result;
+  if (!dmabuf_import_supported_) {
+    return result;
+  }
+
+  if (!dmabuf_modifiers_supported_) {
+    // Without the modifiers extension, only the implicit modifier can be
+    // imported. ARGB8888 and XRGB8888 are always supported.
+    constexpr uint32_t kArgb8888 = 0x34325241;  // 'AR24'
+    constexpr uint32_t kXrgb8888 = 0x34325258;  // 'XR24'
+    result.push_back({kArgb8888, {}});
+    result.push_back({kXrgb8888, {}});
+    return result;
+  }
+
+  EGLint num_formats = 0;
+  if (!eglQueryDmaBufFormatsEXT_(environment_->Display(), 0, nullptr,
+                                 &num_formats)) {
+    WAFFLE_LOG(ERROR) << "Failed to query dmabuf formats: "
+                      << get_egl_error_cause();
+    return result;
+  }
+  std::vector<EGLint> formats(num_formats);
+  eglQueryDmaBufFormatsEXT_(environment_->Display(), num_formats,
+                            formats.data(), &num_formats);
+
+  for (auto format : formats) {
+    EGLint num_modifiers = 0;
+    eglQueryDmaBufModifiersEXT_(environment_->Display(), format, 0, nullptr,
+                                nullptr, &num_modifiers);
+    std::vector<EGLuint64KHR> modifiers(num_modifiers);
+    std::vector<EGLBoolean> external_only(num_modifiers);
+    eglQueryDmaBufModifiersEXT_(environment_->Display(), format,
+                                num_modifiers, modifiers.data(),
+                                external_only.data(), &num_modifiers);
+
+    // External-only modifiers are included as well, because they are
+    // imported as GL_TEXTURE_EXTERNAL_OES.
+    DmabufFormat dmabuf_format = {static_cast<uint32_t>(format), {}};
+    dmabuf_format.modifiers.assign(modifiers.begin(),
+                                   modifiers.begin() + num_modifiers);
+    result.push_back(dmabuf_format);
+  }
+
+  // YUV formats can be imported plane by plane even if EGL doesn't support
+  // them, as long as it supports the formats of all the planes. The
+  // modifiers must be supported by all of them.
+  auto find = [&result](uint32_t format) -> const DmabufFormat* {
+    for (const auto& dmabuf_format : result) {
+      if (dmabuf_format.format == format) {
+        return &dmabuf_format;
+      }
+    }
+    return nullptr;
+  };
+  for (const auto& yuv_import : kYuvImports) {
+    if (find(yuv_import.format)) {
+      continue;
+    }
+    std::vector<const DmabufFormat*> plane_formats;
+    for (int i = 0; i < yuv_import.num_planes; i++) {
+      const auto* plane_format = find(yuv_import.planes[i].format);
+      if (!plane_format) {
+        break;
+      }
+      plane_formats.push_back(plane_format);
+    }
+    if (static_cast<int>(plane_formats.size()) != yuv_import.num_planes) {
+      continue;
+    }
+
+    // An empty list of modifiers means only the implicit modifier.
+    DmabufFormat dmabuf_format = {yuv_import.format,
+                                  plane_formats[0]->modifiers};
+    auto& modifiers = dmabuf_format.modifiers;
+    for (const auto* plane_format : plane_formats) {
+      const auto& plane_modifiers = plane_format->modifiers;
+      if (plane_modifiers.empty()) {
+        modifiers.clear();
+        break;
+      }
+      modifiers.erase(
+          std::remove_if(modifiers.begin(), modifiers.end(),
+                         [&plane_modifiers](uint64_t modifier) {
+                           return std::find(plane_modifiers.begin(),
+                                            plane_modifiers.end(),
+                                            modifier) == plane_modifiers.end();
+                         }),
+          modifiers.end());
+      if (modifiers.empty()) {
+        break;
+      }
+    }
+    if (modifiers.empty() && !plane_formats[0]->modifiers.empty()) {
+      continue;
+    }
+    result.push_back(dmabuf_format);
+  }
+  return result;
+}
+
+bool ContextEgl::LoadDmabufIntoTexture(wl_resource* buffer,
+                                       const DmabufAttributes& attributes,
+                                       Texture& texture) {
+  auto it = buffer_images_.find(buffer);
+  if (it != buffer_images_.end()) {
+    texture = it->second->texture;
+    return true;
+  }
+
+  if (!dmabuf_import_supported_) {
+    WAFFLE_LOG(ERROR) << "EGL_EXT_image_dma_buf_import isn't supported";
+    return false;
+  }
+
+  // YUV buffers are converted by our shaders if the planes can be imported
+  // as RGB images. Otherwise, EGL converts them through
+  // GL_TEXTURE_EXTERNAL_OES.
+  const auto* yuv_import = FindYuvImport(attributes.format);
+  if (yuv_import) {
+    std::vector<EGLImageKHR> images;
+    for (int i = 0; i < yuv_import->num_planes; i++) {
+      const auto& plane_import = yuv_import->planes[i];
+      if (plane_import.plane >= attributes.num_planes) {
+        break;
+      }
+      // Subsampled planes of odd sizes cover the last column and row, like
+      // PlaneLayout::ToPlaneRect() in texture.cc.
+      auto h = plane_import.horizontal_subsampling;
+      auto v = plane_import.vertical_subsampling;
+      auto image = CreateDmabufImage(
+          plane_import.format, (attributes.width + h - 1) / h,
+          (attributes.height + v - 1) / v,
+          &attributes.planes[plane_import.plane], 1);
+      if (image == EGL_NO_IMAGE_KHR) {
+        break;
+      }
+      images.push_back(image);
+    }
+    if (static_cast<int>(images.size()) == yuv_import->num_planes) {
+      auto& cached = CacheBufferImage(buffer, images);
+      cached.LoadEGLImagePlanes(
+          std::vector<void*>(images.begin(), images.end()), attributes.width,
+          attributes.height, yuv_import->texture_format);
+      texture = cached;
+      return true;
+    }
+    for (auto image : images) {
+      eglDestroyImageKHR_(environment_->Display(), image);
+    }
+  }
+
+  EGLImageKHR eglImageKhr =
+      CreateDmabufImage(attributes.format, attributes.width, attributes.height,
+                        attributes.planes.data(), attributes.num_planes);
+  if (eglImageKhr == EGL_NO_IMAGE_KHR) {
+    WAFFLE_LOG(ERROR) << "Failed to import dmabuf: " << get_egl_error_cause();
+    return false;
+  }
+  auto external =
+      yuv_import ||
+      IsExternalOnly(attributes.format, attributes.planes[0].modifier);
+  auto& cached = CacheBufferImage(buffer, {eglImageKhr});
+  cached.LoadEGLImage((EGLImage)eglImageKhr, attributes.width,
+                      attributes.height, external);
+  texture = cached;
+  return true;
+}
+
+EGLImageKHR ContextEgl::CreateDmabufImage(
+    uint32_t format,
+    int width,
+    int height,
+    const DmabufAttributes::Plane* planes,
+    int num_planes) const {
+  static const EGLint kPlaneAttribs[kDmabufMaxPlanes][5] = {
+      // clang-format off
+      {EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+       EGL_DMA_BUF_PLANE0_PITCH_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT,
+       EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT},
+      {EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT,
+       EGL_DMA_BUF_PLANE1_PITCH_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT,
+       EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT},
+      {EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT,
+       EGL_DMA_BUF_PLANE2_PITCH_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT,
+       EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT},
+      {EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT,
+       EGL_DMA_BUF_PLANE3_PITCH_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT,
+       EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT},
+      // clang-format on
+  };
+
+  std::vector<EGLint> attribs = {
+      // clang-format off
+      EGL_WIDTH,                 width,
+      EGL_HEIGHT,                height,
+      EGL_LINUX_DRM_FOURCC_EXT,  static_cast<EGLint>(format),
+      // clang-format on
+  };
+  for (int i = 0; i < num_planes; i++) {
+    const auto& plane = planes[i];
+    attribs.push_back(kPlaneAttribs[i][0]);
+    attribs.push_back(plane.fd);
+    attribs.push_back(kPlaneAttribs[i][1]);
+    attribs.push_back(plane.offset);
+    attribs.push_back(kPlaneAttribs[i][2]);
+    attribs.push_back(plane.stride);
+    if (dmabuf_modifiers_supported_ &&
+        plane.modifier != kDmabufModifierInvalid) {
+      attribs.push_back(kPlaneAttribs[i][3]);
+      attribs.push_back(static_cast<EGLint>(plane.modifier & 0xffffffff));
+      attribs.push_back(kPlaneAttribs[i][4]);
+      attribs.push_back(static_cast<EGLint>(plane.modifier >> 32));
+    }
+  }
+  attribs.push_back(EGL_NONE);
+
+  return eglCreateImageKHR_(environment_->Display(), EGL_NO_CONTEXT,
+                            EGL_LINUX_DMA_BUF_EXT, nullptr, attribs.data());
+}
+
+bool ContextEgl::IsExternalOnly(uint32_t format, uint64_t modifier) const {
+  // EGL can't tell it for the implicit modifier, and GL_TEXTURE_2D is tried
+  // then as before.
+  if (!dmabuf_modifiers_supported_ || modifier == kDmabufModifierInvalid) {
+    return false;
+  }
+
+  EGLint num_modifiers = 0;
+  eglQueryDmaBufModifiersEXT_(environment_->Display(), format, 0, nullptr,
+                              nullptr, &num_modifiers);
+  std::vector<EGLuint64KHR> modifiers(num_modifiers);
+  std::vector<EGLBoolean> external_only(num_modifiers);
+  eglQueryDmaBufModifiersEXT_(environment_->Display(), format, num_modifiers,
+                              modifiers.data(), external_only.data(),
+                              &num_modifiers);
+  for (EGLint i = 0; i < num_modifiers; i++) {
+    if (modifiers[i] == modifier) {
+      return external_only[i];
+    }
+  }
+  return false;
+}
+
+Texture& ContextEgl::CacheBufferImage(wl_resource* buffer,
+                                      std::vector<EGLImageKHR> images) {
+  auto buffer_image = std::make_unique<BufferImage>();
+  buffer_image->context = this;
+  buffer_image->buffer = buffer;
+  buffer_image->images = std::move(images);
+  buffer_image->destroy_listener.notify = +[](wl_listener* listener,
+                                              void* data) {
+    BufferImage* buffer_image =
+        wl_container_of(listener, buffer_image, destroy_listener);
+    buffer_image->context->DestroyBufferImage(buffer_image);
+  };
+  wl_resource_add_destroy_listener(buffer, &buffer_image->destroy_listener);
+
+  auto& texture = buffer_image->texture;
+  buffer_images_[buffer] = std::move(buffer_image);
+  return texture;
+}
+
+void ContextEgl::DestroyBufferImage(BufferImage* buffer_image) {
+  wl_list_remove(&buffer_image->destroy_listener.link);
+  for (auto image : buffer_image->images) {
+    eglDestroyImageKHR_(environment_->Display(), image);
+  }
+  buffer_images_.erase(buffer_image->buffer);
 }
 
 }  // namespace waffle
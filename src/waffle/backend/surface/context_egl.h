@@ -10,7 +10,10 @@
 #include <EGL/eglext.h>
 
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
+#include "waffle/backend/surface/dmabuf_attributes.h"
 #include "waffle/backend/surface/environment_egl.h"
 #include "waffle/backend/surface/linux_egl_surface.h"
 #include "waffle/backend/window/native_window.h"
@@ -22,7 +25,7 @@ class ContextEgl {
  public:
   ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
              EGLint egl_surface_type = EGL_WINDOW_BIT);
-  ~ContextEgl() = default;
+  ~ContextEgl();
 
   virtual std::unique_ptr<LinuxEGLSurface> CreateOnscreenSurface(
       NativeWindow* window) const;
@@ -42,9 +45,44 @@ class ContextEgl {
 
   bool UnbindWlDisplay(wl_display* display);
 
+  // Binds the contents of a client's EGL buffer to |texture|. The EGLImage
+  // and the texture are cached per wl_buffer until it is destroyed, so
+  // re-attaching a known buffer doesn't create a new image.
   void LoadIntoTexture(wl_resource* buffer, Texture& texture);
 
+  // Returns the dmabuf formats and modifiers which can be imported. This is
+  // empty when EGL_EXT_image_dma_buf_import isn't supported.
+  std::vector<DmabufFormat> QueryDmabufFormats() const;
+
+  // Imports a client's dmabuf buffer into |texture| without a copy. The
+  // import is cached in the same way as LoadIntoTexture(). Returns false if
+  // EGL rejects the buffer.
+  bool LoadDmabufIntoTexture(wl_resource* buffer,
+                             const DmabufAttributes& attributes,
+                             Texture& texture);
+
  protected:
+  struct BufferImage;
+
+  // Returns true if the dmabuf of |format| and |modifier| can only be
+  // sampled as GL_TEXTURE_EXTERNAL_OES.
+  bool IsExternalOnly(uint32_t format, uint64_t modifier) const;
+
+  // Imports |num_planes| of |planes| as an EGLImage of |format|. Returns
+  // EGL_NO_IMAGE_KHR if EGL rejects them.
+  EGLImageKHR CreateDmabufImage(uint32_t format,
+                                int width,
+                                int height,
+                                const DmabufAttributes::Plane* planes,
+                                int num_planes) const;
+
+  // Keeps |images| of |buffer| until the buffer is destroyed. Returns the
+  // texture cached with them, which the images should be bound to.
+  Texture& CacheBufferImage(wl_resource* buffer,
+                            std::vector<EGLImageKHR> images);
+
+  void DestroyBufferImage(BufferImage* buffer_image);
+
   std::unique_ptr<EnvironmentEgl> environment_;
   EGLConfig config_;
   EGLContext context_;
@@ -55,6 +93,14 @@ class ContextEgl {
   PFNEGLUNBINDWAYLANDDISPLAYWL eglUnbindWaylandDisplayWL_ = nullptr;
   PFNEGLQUERYWAYLANDBUFFERWL eglQueryWaylandBufferWL_ = nullptr;
   PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR_ = nullptr;
+  PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR_ = nullptr;
+  PFNEGLQUERYDMABUFFORMATSEXTPROC eglQueryDmaBufFormatsEXT_ = nullptr;
+  PFNEGLQUERYDMABUFMODIFIERSEXTPROC eglQueryDmaBufModifiersEXT_ = nullptr;
+  bool dmabuf_import_supported_ = false;
+  bool dmabuf_modifiers_supported_ = false;
+
+  std::unordered_map<wl_resource*, std::unique_ptr<BufferImage>>
+      buffer_images_;
 };
 
 }  // namespace waffle
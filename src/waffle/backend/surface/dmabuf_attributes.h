@@ -0,0 +1,44 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_BACKEND_SURFACE_DMABUF_ATTRIBUTES_H_
+#define WAFFLE_BACKEND_SURFACE_DMABUF_ATTRIBUTES_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace waffle {
+
+// Same as DRM_FORMAT_MOD_INVALID in drm_fourcc.h.
+constexpr uint64_t kDmabufModifierInvalid = 0x00ffffffffffffffULL;
+
+constexpr int kDmabufMaxPlanes = 4;
+
+// A DRM fourcc format and the modifiers which can be imported with it.
+struct DmabufFormat {
+  uint32_t format;
+  std::vector<uint64_t> modifiers;
+};
+
+// Describes a client buffer which consists of dmabuf planes.
+struct DmabufAttributes {
+  struct Plane {
+    int fd = -1;
+    uint32_t offset = 0;
+    uint32_t stride = 0;
+    uint64_t modifier = kDmabufModifierInvalid;
+  };
+
+  int32_t width = 0;
+  int32_t height = 0;
+  uint32_t format = 0;
+  uint32_t flags = 0;
+  int num_planes = 0;
+  std::array<Plane, kDmabufMaxPlanes> planes;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_BACKEND_SURFACE_DMABUF_ATTRIBUTES_H_
@@ -5,6 +5,10 @@
 
 #include "waffle/backend/surface/linux_egl_surface.h"
 
+#include <EGL/eglext.h>
+
+#include <cstring>
+
 #include "waffle/backend/surface/egl_utils.h"
 #include "waffle/logger.h"
 
@@ -13,7 +17,11 @@ namespace waffle {
 LinuxEGLSurface::LinuxEGLSurface(EGLSurface surface,
                                  EGLDisplay display,
                                  EGLContext context)
-    : surface_(surface), display_(display), context_(context){};
+    : surface_(surface), display_(display), context_(context) {
+  auto* extensions = eglQueryString(display_, EGL_EXTENSIONS);
+  buffer_age_supported_ =
+      extensions && std::strstr(extensions, "EGL_EXT_buffer_age");
+};
 
 LinuxEGLSurface::~LinuxEGLSurface() {
   if (surface_ != EGL_NO_SURFACE) {
@@ -58,4 +66,19 @@ bool LinuxEGLSurface::SwapBuffers() const {
   return true;
 }
 
+int LinuxEGLSurface::BufferAge() const {
+  if (!buffer_age_supported_) {
+    return 0;
+  }
+
+  EGLint age = 0;
+  if (eglQuerySurface(display_, surface_, EGL_BUFFER_AGE_EXT, &age) !=
+      EGL_TRUE) {
+    WAFFLE_LOG(ERROR) << "Failed to query the buffer age: "
+                      << get_egl_error_cause();
+    return 0;
+  }
+  return age;
+}
+
 }  // namespace waffle
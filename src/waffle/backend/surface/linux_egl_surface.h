@@ -22,10 +22,17 @@ class LinuxEGLSurface {
 
   bool SwapBuffers() const;
 
+  // Returns the age of the current back buffer (EGL_EXT_buffer_age). The age
+  // is the number of frames since its contents were presented. 0 means the
+  // contents are undefined, and it is always 0 if the extension is not
+  // supported.
+  int BufferAge() const;
+
  private:
   EGLDisplay display_;
   EGLSurface surface_;
   EGLContext context_;
+  bool buffer_age_supported_ = false;
 };
 
 }  // namespace waffle
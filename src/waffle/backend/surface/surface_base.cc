@@ -6,6 +6,7 @@
 #include "waffle/backend/surface/surface_base.h"
 
 #include "waffle/logger.h"
+#include "waffle/renderer/gl_state.h"
 
 namespace waffle {
 
@@ -39,6 +40,8 @@ bool SurfaceBase::OnScreenSurfaceResize(const size_t width,
 
   if (native_window_->IsNeedRecreateSurfaceAfterResize()) {
     DestroyOnScreenContext();
+    // The cached GL state isn't trusted across the new surface.
+    GlState::Instance().Invalidate();
     onscreen_surface_ = context_->CreateOnscreenSurface(native_window_);
     if (!onscreen_surface_->IsValid()) {
       WAFFLE_LOG(WARNING) << "Failed to recreate on-screen surface.";
@@ -65,10 +68,27 @@ bool SurfaceBase::ResourceContextMakeCurrent() const {
   return offscreen_surface_->MakeCurrent();
 };
 
+int SurfaceBase::GetBufferAge() const {
+  if (!onscreen_surface_) {
+    return 0;
+  }
+  return onscreen_surface_->BufferAge();
+}
+
 void SurfaceBase::LoadIntoTexture(wl_resource* buffer, Texture& texture) const {
   context_->LoadIntoTexture(buffer, texture);
 }
 
+std::vector<DmabufFormat> SurfaceBase::QueryDmabufFormats() const {
+  return context_->QueryDmabufFormats();
+}
+
+bool SurfaceBase::LoadDmabufIntoTexture(wl_resource* buffer,
+                                        const DmabufAttributes& attributes,
+                                        Texture& texture) const {
+  return context_->LoadDmabufIntoTexture(buffer, attributes, texture);
+}
+
 void SurfaceBase::BindWlDisplay(wl_display* display) const {
   context_->BindWlDisplay(display);
 }
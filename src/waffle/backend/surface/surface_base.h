@@ -9,8 +9,10 @@
 #include <wayland-server.h>
 
 #include <memory>
+#include <vector>
 
 #include "waffle/backend/surface/context_egl.h"
+#include "waffle/backend/surface/dmabuf_attributes.h"
 #include "waffle/backend/surface/linux_egl_surface.h"
 #include "waffle/backend/window/native_window.h"
 #include "waffle/renderer/texture.h"
@@ -43,9 +45,21 @@ class SurfaceBase {
   // Makes an off-screen resource context.
   bool ResourceContextMakeCurrent() const;
 
+  // Returns the age of the on-screen back buffer. 0 means that the whole
+  // frame needs to be redrawn.
+  int GetBufferAge() const;
+
   //
   void LoadIntoTexture(wl_resource* buffer, Texture& texture) const;
 
+  // Returns the dmabuf formats and modifiers which can be imported.
+  std::vector<DmabufFormat> QueryDmabufFormats() const;
+
+  // Imports a client's dmabuf buffer into |texture|.
+  bool LoadDmabufIntoTexture(wl_resource* buffer,
+                             const DmabufAttributes& attributes,
+                             Texture& texture) const;
+
   //
   void BindWlDisplay(wl_display* display) const;
 
@@ -0,0 +1,63 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/backend/window/frame_clock.h"
+
+#include <algorithm>
+
+namespace waffle {
+
+namespace {
+constexpr int32_t kDefaultFrameRate = 60000;
+constexpr std::chrono::milliseconds kDefaultRepaintDeadline(7);
+}  // namespace
+
+FrameClock::FrameClock() : repaint_deadline_(kDefaultRepaintDeadline) {
+  SetFrameRate(kDefaultFrameRate);
+}
+
+void FrameClock::SetFrameRate(int32_t frame_rate) {
+  if (frame_rate <= 0) {
+    frame_rate = kDefaultFrameRate;
+  }
+  refresh_interval_ = std::chrono::nanoseconds(1000000000000LL / frame_rate);
+}
+
+void FrameClock::SetRepaintDeadline(std::chrono::nanoseconds deadline) {
+  repaint_deadline_ = deadline;
+}
+
+void FrameClock::Presented(const Presentation& presentation) {
+  last_presentation_ = presentation;
+  presented_ = true;
+}
+
+FrameClock::Clock::time_point FrameClock::NextPresentationTime(
+    Clock::time_point now) const {
+  auto deadline = RepaintDeadline();
+  if (!presented_) {
+    return now + deadline;
+  }
+
+  // Extrapolates the vblank timings from the last presentation. A frame can
+  // be shown at the first vblank whose deadline hasn't passed yet.
+  auto next = last_presentation_.time + refresh_interval_;
+  if (next - deadline < now) {
+    auto missed = (now - (next - deadline)) / refresh_interval_ + 1;
+    next += missed * refresh_interval_;
+  }
+  return next;
+}
+
+FrameClock::Clock::time_point FrameClock::NextRepaintTime(
+    Clock::time_point now) const {
+  return NextPresentationTime(now) - RepaintDeadline();
+}
+
+std::chrono::nanoseconds FrameClock::RepaintDeadline() const {
+  return std::clamp(repaint_deadline_, std::chrono::nanoseconds(0),
+                    refresh_interval_);
+}
+
+}  // namespace waffle
@@ -0,0 +1,70 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_BACKEND_WINDOW_FRAME_CLOCK_H_
+#define WAFFLE_BACKEND_WINDOW_FRAME_CLOCK_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace waffle {
+
+// Predicts when the next frame will be shown on the display from the times
+// when the previous frames were shown, and tells when the compositor should
+// start drawing it.
+class FrameClock {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // How and when a frame was shown on the display.
+  struct Presentation {
+    Clock::time_point time;
+    // The vblank counter of the display. 0 if it's not available.
+    uint64_t sequence = 0;
+    // Whether the frame was shown at a vblank without tearing.
+    bool vsync = false;
+    // Whether |time| was taken by the display hardware.
+    bool hw_clock = false;
+    // Whether the completion was notified by the display hardware.
+    bool hw_completion = false;
+  };
+
+  FrameClock();
+  ~FrameClock() = default;
+
+  // Sets the refresh rate of the display in mHz.
+  void SetFrameRate(int32_t frame_rate);
+
+  // Sets how long before the presentation the compositor starts drawing a
+  // frame. The drawing must be completed within this time.
+  void SetRepaintDeadline(std::chrono::nanoseconds deadline);
+
+  std::chrono::nanoseconds RefreshInterval() const { return refresh_interval_; }
+
+  // Records that a frame was shown.
+  void Presented(const Presentation& presentation);
+
+  const Presentation& LastPresentation() const { return last_presentation_; }
+
+  // Returns the earliest time when a frame which starts to be drawn at |now|
+  // can be shown.
+  Clock::time_point NextPresentationTime(Clock::time_point now) const;
+
+  // Returns the time when the compositor should start drawing the frame which
+  // is shown at NextPresentationTime(|now|).
+  Clock::time_point NextRepaintTime(Clock::time_point now) const;
+
+ private:
+  // Returns the repaint deadline which is limited to a refresh interval.
+  std::chrono::nanoseconds RepaintDeadline() const;
+
+  std::chrono::nanoseconds refresh_interval_;
+  std::chrono::nanoseconds repaint_deadline_;
+  Presentation last_presentation_;
+  bool presented_ = false;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_BACKEND_WINDOW_FRAME_CLOCK_H_
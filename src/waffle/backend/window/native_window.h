@@ -7,6 +7,9 @@
 #define WAFFLE_BACKEND_WINDOW_NATIVE_WINDOW_H_
 
 #include <EGL/egl.h>
+#include <wayland-server.h>
+
+#include "waffle/backend/surface/dmabuf_attributes.h"
 
 namespace waffle {
 
@@ -51,9 +54,22 @@ class NativeWindow {
   // backend. It is prepared to make the interface common.
   virtual void SwapBuffers(){/* do nothing. */};
 
+  // Shows a client's dmabuf buffer on the display directly instead of the
+  // composited frame. Returns false when the buffer can't be scanned out, and
+  // then the frame needs to be composited. This API performs processing only
+  // for the DRM-GBM backend. |buffer| is the wl_buffer of |attributes|.
+  virtual bool ScanoutBuffer(wl_resource* buffer,
+                             const DmabufAttributes& attributes) {
+    return false;
+  }
+
+  // Whether the last frame is still waiting to be shown on the display. The
+  // next frame must not be submitted until it's shown.
+  virtual bool IsFlipPending() const { return false; }
+
  protected:
-  EGLNativeWindowType window_;
-  EGLNativeWindowType window_offscreen_;
+  EGLNativeWindowType window_{};
+  EGLNativeWindowType window_offscreen_{};
   int32_t width_;
   int32_t height_;
   int32_t x_;
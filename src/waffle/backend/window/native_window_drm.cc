@@ -10,6 +10,7 @@
 #include <xf86drm.h>
 
 #include <unordered_map>
+#include <vector>
 
 #include "waffle/backend/window/cursor_data.h"
 #include "waffle/logger.h"
@@ -33,10 +34,55 @@ NativeWindowDrm::NativeWindowDrm(const char* device_filename,
 
 NativeWindowDrm::~NativeWindowDrm() {
   if (drm_device_ != -1) {
+    if (drm_mode_blob_id_) {
+      drmModeDestroyPropertyBlob(drm_device_, drm_mode_blob_id_);
+    }
     close(drm_device_);
   }
 }
 
+int32_t NativeWindowDrm::RefreshRate() const {
+  if (!drm_mode_info_.htotal || !drm_mode_info_.vtotal) {
+    return drm_mode_info_.vrefresh * 1000;
+  }
+  // |clock| is the pixel clock in kHz.
+  auto pixels_per_frame =
+      static_cast<int64_t>(drm_mode_info_.htotal) * drm_mode_info_.vtotal;
+  return (drm_mode_info_.clock * 1000000LL + pixels_per_frame / 2) /
+         pixels_per_frame;
+}
+
+bool NativeWindowDrm::DispatchDrmEvent() {
+  drmEventContext context = {};
+  context.version = 2;
+  context.page_flip_handler = [](int fd, unsigned int sequence,
+                                 unsigned int tv_sec, unsigned int tv_usec,
+                                 void* user_data) {
+    auto self = reinterpret_cast<NativeWindowDrm*>(user_data);
+    self->page_flip_completed_ = true;
+    auto& flip = self->last_page_flip_;
+    flip.sequence = sequence;
+    flip.vsync = true;
+    flip.hw_completion = true;
+    // The timestamp is the start of the vblank in CLOCK_MONOTONIC, which is
+    // the same clock as std::chrono::steady_clock on Linux.
+    flip.hw_clock = tv_sec || tv_usec;
+    if (flip.hw_clock) {
+      flip.time = FrameClock::Clock::time_point(
+          std::chrono::seconds(tv_sec) + std::chrono::microseconds(tv_usec));
+    } else {
+      flip.time = FrameClock::Clock::now();
+    }
+    self->OnPageFlip();
+  };
+
+  page_flip_completed_ = false;
+  if (drmHandleEvent(drm_device_, &context) != 0) {
+    WAFFLE_LOG(ERROR) << "Failed to handle DRM events.";
+  }
+  return page_flip_completed_;
+}
+
 bool NativeWindowDrm::MoveCursor(double x, double y) {
   auto result =
       drmModeMoveCursor(drm_device_, drm_crtc_->crtc_id,
@@ -82,6 +128,11 @@ bool NativeWindowDrm::ConfigureDisplay(const uint16_t rotation) {
     drm_crtc_ = drmModeGetCrtc(drm_device_, encoder->crtc_id);
   }
 
+  atomic_modesetting_ = drm_crtc_ && SetupAtomicModesetting(resources);
+  WAFFLE_LOG(INFO) << "modesetting: "
+                   << (atomic_modesetting_ ? "atomic" : "legacy");
+  modeset_pending_ = true;
+
   drmModeFreeEncoder(encoder);
   drmModeFreeConnector(connector);
   drmModeFreeResources(resources);
@@ -111,6 +162,116 @@ drmModeEncoder* NativeWindowDrm::FindEncoder(drmModeRes* resources,
   return nullptr;
 }
 
+bool NativeWindowDrm::SetupAtomicModesetting(drmModeRes* resources) {
+  if (drmSetClientCap(drm_device_, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1) != 0 ||
+      drmSetClientCap(drm_device_, DRM_CLIENT_CAP_ATOMIC, 1) != 0) {
+    WAFFLE_LOG(INFO) << "The DRM device doesn't support atomic modesetting.";
+    return false;
+  }
+
+  // Planes can be used with a CRTC specified by its index in the resources.
+  int crtc_index = -1;
+  for (int i = 0; i < resources->count_crtcs; i++) {
+    if (resources->crtcs[i] == drm_crtc_->crtc_id) {
+      crtc_index = i;
+      break;
+    }
+  }
+  if (crtc_index < 0) {
+    WAFFLE_LOG(ERROR) << "Couldn't find the CRTC in the resources.";
+    return false;
+  }
+
+  auto plane_resources = drmModeGetPlaneResources(drm_device_);
+  if (!plane_resources) {
+    WAFFLE_LOG(ERROR) << "Couldn't get plane resources.";
+    return false;
+  }
+  drm_plane_id_ = 0;
+  for (uint32_t i = 0; i < plane_resources->count_planes && !drm_plane_id_;
+       i++) {
+    auto plane = drmModeGetPlane(drm_device_, plane_resources->planes[i]);
+    if (!plane) {
+      continue;
+    }
+    if (plane->possible_crtcs & (1 << crtc_index)) {
+      auto properties =
+          GetDrmProperties(plane->plane_id, DRM_MODE_OBJECT_PLANE);
+      auto type = properties.find("type");
+      if (type != properties.end() &&
+          type->second.value == DRM_PLANE_TYPE_PRIMARY) {
+        drm_plane_id_ = plane->plane_id;
+        drm_plane_properties_ = std::move(properties);
+      }
+    }
+    drmModeFreePlane(plane);
+  }
+  drmModeFreePlaneResources(plane_resources);
+  if (!drm_plane_id_) {
+    WAFFLE_LOG(ERROR) << "Couldn't find the primary plane.";
+    return false;
+  }
+
+  drm_connector_properties_ =
+      GetDrmProperties(drm_connector_id_, DRM_MODE_OBJECT_CONNECTOR);
+  drm_crtc_properties_ =
+      GetDrmProperties(drm_crtc_->crtc_id, DRM_MODE_OBJECT_CRTC);
+
+  const std::pair<const DrmProperties&, std::vector<std::string>>
+      required_properties[] = {
+          {drm_connector_properties_, {"CRTC_ID"}},
+          {drm_crtc_properties_, {"MODE_ID", "ACTIVE"}},
+          {drm_plane_properties_,
+           {"FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H", "CRTC_X",
+            "CRTC_Y", "CRTC_W", "CRTC_H"}},
+      };
+  for (const auto& [properties, names] : required_properties) {
+    for (const auto& name : names) {
+      if (properties.find(name) == properties.end()) {
+        WAFFLE_LOG(ERROR) << "Couldn't find the property: " << name;
+        return false;
+      }
+    }
+  }
+
+  if (drm_mode_blob_id_) {
+    drmModeDestroyPropertyBlob(drm_device_, drm_mode_blob_id_);
+    drm_mode_blob_id_ = 0;
+  }
+  if (drmModeCreatePropertyBlob(drm_device_, &drm_mode_info_,
+                                sizeof(drm_mode_info_),
+                                &drm_mode_blob_id_) != 0) {
+    WAFFLE_LOG(ERROR) << "Couldn't create the mode blob.";
+    return false;
+  }
+
+  return true;
+}
+
+NativeWindowDrm::DrmProperties NativeWindowDrm::GetDrmProperties(
+    uint32_t object_id,
+    uint32_t object_type) {
+  DrmProperties properties;
+  auto object_properties =
+      drmModeObjectGetProperties(drm_device_, object_id, object_type);
+  if (!object_properties) {
+    return properties;
+  }
+
+  for (uint32_t i = 0; i < object_properties->count_props; i++) {
+    auto property =
+        drmModeGetProperty(drm_device_, object_properties->props[i]);
+    if (!property) {
+      continue;
+    }
+    properties[property->name] = {property->prop_id,
+                                  object_properties->prop_values[i]};
+    drmModeFreeProperty(property);
+  }
+  drmModeFreeObjectProperties(object_properties);
+  return properties;
+}
+
 const uint32_t* NativeWindowDrm::GetCursorData(const std::string& cursor_name) {
   // const uint32_t* NativeWindowDrm::GetCursorData(const std::string&
   // cursor_name) { If there is no cursor data corresponding to the Flutter's
@@ -9,8 +9,10 @@
 #include <xf86drmMode.h>
 
 #include <string>
+#include <unordered_map>
 
 #include "waffle/backend/surface/surface_gl.h"
+#include "waffle/backend/window/frame_clock.h"
 #include "waffle/backend/window/native_window.h"
 
 namespace waffle {
@@ -34,12 +36,44 @@ class NativeWindowDrm : public NativeWindow {
 
   virtual std::unique_ptr<SurfaceGl> CreateRenderSurface() = 0;
 
+  int DrmDevice() const { return drm_device_; }
+
+  // Returns the refresh rate of the current mode in mHz.
+  int32_t RefreshRate() const;
+
+  // Handles the pending events on the DRM device such as page flip
+  // completions. Returns true if a frame was presented by them.
+  bool DispatchDrmEvent();
+
+  // Returns when the last page flip was completed.
+  const FrameClock::Presentation& LastPageFlip() const {
+    return last_page_flip_;
+  }
+
  protected:
+  struct DrmProperty {
+    uint32_t id;
+    uint64_t value;
+  };
+
+  using DrmProperties = std::unordered_map<std::string, DrmProperty>;
+
+  // Called when a page flip which was requested with
+  // DRM_MODE_PAGE_FLIP_EVENT is completed.
+  virtual void OnPageFlip() {}
+
   drmModeConnectorPtr FindConnector(drmModeResPtr resources);
 
   drmModeEncoder* FindEncoder(drmModeRes* resources,
                               drmModeConnector* connector);
 
+  // Enables atomic modesetting and looks up the KMS objects and the properties
+  // which are needed for it. Returns false if the driver doesn't support it,
+  // and then the legacy API is used instead.
+  bool SetupAtomicModesetting(drmModeRes* resources);
+
+  DrmProperties GetDrmProperties(uint32_t object_id, uint32_t object_type);
+
   // Convert Flutter's cursor value to cursor data.
   const uint32_t* GetCursorData(const std::string& cursor_name);
 
@@ -48,6 +82,20 @@ class NativeWindowDrm : public NativeWindow {
   drmModeCrtc* drm_crtc_ = nullptr;
   drmModeModeInfo drm_mode_info_;
 
+  // Atomic modesetting states. These are valid only if |atomic_modesetting_|
+  // is true.
+  bool atomic_modesetting_ = false;
+  uint32_t drm_plane_id_ = 0;
+  uint32_t drm_mode_blob_id_ = 0;
+  DrmProperties drm_connector_properties_;
+  DrmProperties drm_crtc_properties_;
+  DrmProperties drm_plane_properties_;
+  // Whether the next commit needs to set the mode. e.g. the first frame and
+  // after the display was reconnected.
+  bool modeset_pending_ = true;
+  bool page_flip_completed_ = false;
+  FrameClock::Presentation last_page_flip_;
+
   std::string cursor_name_ = "";
   std::pair<int32_t, int32_t> cursor_hotspot_ = {0, 0};
 };
@@ -18,8 +18,24 @@ constexpr char kCursorNameNone[] = "none";
 // restrictions of drmModeSetCursor API.
 constexpr uint32_t kCursorBufferWidth = 64;
 constexpr uint32_t kCursorBufferHeight = 64;
+
+// KMS framebuffer which is attached to a gbm_bo as its user data. It's removed
+// when the gbm_bo is destroyed.
+struct BoFramebuffer {
+  int drm_device;
+  uint32_t id;
+};
 }  // namespace
 
+struct NativeWindowDrmGbm::ScanoutImport {
+  NativeWindowDrmGbm* window;
+  wl_resource* buffer;
+  // nullptr if the buffer can't be scanned out.
+  gbm_bo* bo = nullptr;
+  uint32_t fb_id = 0;
+  wl_listener destroy_listener;
+};
+
 NativeWindowDrmGbm::NativeWindowDrmGbm(const char* device_filename,
                                        const uint16_t rotation)
     : NativeWindowDrm(device_filename, rotation) {
@@ -62,13 +78,17 @@ NativeWindowDrmGbm::~NativeWindowDrmGbm() {
     drmModeFreeCrtc(drm_crtc_);
   }
 
-  if (gbm_previous_bo_) {
-    drmModeRmFB(drm_device_, gbm_previous_fb_);
-    gbm_surface_release_buffer(static_cast<gbm_surface*>(window_),
-                               gbm_previous_bo_);
+  ReleaseFramebuffer(pending_fb_);
+  ReleaseFramebuffer(front_fb_);
+  while (!scanout_imports_.empty()) {
+    DestroyScanoutImport(scanout_imports_.begin()->second.get());
+  }
+
+  if (window_) {
     gbm_surface_destroy(static_cast<gbm_surface*>(window_));
     window_ = nullptr;
-
+  }
+  if (window_offscreen_) {
     gbm_surface_destroy(static_cast<gbm_surface*>(window_offscreen_));
     window_offscreen_ = nullptr;
   }
@@ -145,17 +165,15 @@ bool NativeWindowDrmGbm::Resize(const size_t width, const size_t height) {
     return false;
   }
 
-  if (!gbm_previous_bo_) {
+  if (!front_fb_.bo && !pending_fb_.bo) {
     // Do nothing until SwapBuffers() is called.
     // For example, called at the initialization process.
     return false;
   }
 
   WAFFLE_LOG(INFO) << "resize: " << width << "x" << height;
-  drmModeRmFB(drm_device_, gbm_previous_fb_);
-  gbm_surface_release_buffer(static_cast<gbm_surface*>(window_),
-                             gbm_previous_bo_);
-  gbm_previous_bo_ = nullptr;
+  ReleaseFramebuffer(pending_fb_);
+  ReleaseFramebuffer(front_fb_);
 
   gbm_surface_destroy(static_cast<gbm_surface*>(window_));
   if (!CreateGbmSurface()) {
@@ -165,30 +183,280 @@ bool NativeWindowDrmGbm::Resize(const size_t width, const size_t height) {
 }
 
 void NativeWindowDrmGbm::SwapBuffers() {
-  auto* bo = gbm_surface_lock_front_buffer(static_cast<gbm_surface*>(window_));
-  auto width = gbm_bo_get_width(bo);
-  auto height = gbm_bo_get_height(bo);
-  auto handle = gbm_bo_get_handle(bo).u32;
-  auto stride = gbm_bo_get_stride(bo);
-  uint32_t fb;
-  int result =
-      drmModeAddFB(drm_device_, width, height, 24, 32, stride, handle, &fb);
-  if (result != 0) {
-    WAFFLE_LOG(ERROR) << "Failed to add a framebuffer. (" << result << ")";
+  Framebuffer fb;
+  fb.bo = gbm_surface_lock_front_buffer(static_cast<gbm_surface*>(window_));
+  // The display doesn't blend the primary plane, so the alpha channel of the
+  // surface is ignored.
+  auto format = gbm_bo_get_format(fb.bo);
+  if (format == GBM_FORMAT_ARGB8888) {
+    format = GBM_FORMAT_XRGB8888;
+  }
+  fb.id = GetFramebufferId(fb.bo, format);
+  if (!fb.id) {
+    gbm_surface_release_buffer(static_cast<gbm_surface*>(window_), fb.bo);
+    return;
   }
-  result = drmModeSetCrtc(drm_device_, drm_crtc_->crtc_id, fb, 0, 0,
-                          &drm_connector_id_, 1, &drm_mode_info_);
+
+  if (!Present(fb)) {
+    ReleaseFramebuffer(fb);
+  }
+}
+
+bool NativeWindowDrmGbm::ScanoutBuffer(wl_resource* buffer,
+                                       const DmabufAttributes& attributes) {
+  // The primary plane can't scale the buffer.
+  if (attributes.width != drm_mode_info_.hdisplay ||
+      attributes.height != drm_mode_info_.vdisplay) {
+    return false;
+  }
+
+  auto* import = GetScanoutImport(buffer, attributes);
+  if (!import) {
+    return false;
+  }
+
+  Framebuffer scanout_fb = {.bo = import->bo, .id = import->fb_id,
+                            .scanout = true};
+  // Failures here may be transient, e.g. a commit racing a modeset, so the
+  // frame is just composited instead.
+  return Present(scanout_fb);
+}
+
+bool NativeWindowDrmGbm::Present(const Framebuffer& fb) {
+  if (pending_fb_.bo) {
+    WAFFLE_LOG(ERROR) << "The previous frame is not shown yet.";
+    return false;
+  }
+
+  if (atomic_modesetting_) {
+    if (!CommitAtomic(fb)) {
+      return false;
+    }
+    pending_fb_ = fb;
+    return true;
+  }
+
+  auto result = drmModeSetCrtc(drm_device_, drm_crtc_->crtc_id, fb.id, 0, 0,
+                               &drm_connector_id_, 1, &drm_mode_info_);
   if (result != 0) {
     WAFFLE_LOG(ERROR) << "Failed to set crct mode. (" << result << ")";
+    return false;
+  }
+  ReleaseFramebuffer(front_fb_);
+  front_fb_ = fb;
+  return true;
+}
+
+bool NativeWindowDrmGbm::CommitAtomic(const Framebuffer& fb, bool test_only) {
+  auto* request = drmModeAtomicAlloc();
+  auto add_property = [request](uint32_t object_id,
+                                const DrmProperties& properties,
+                                const char* name, uint64_t value) {
+    drmModeAtomicAddProperty(request, object_id, properties.at(name).id,
+                             value);
+  };
+
+  auto crtc_id = drm_crtc_->crtc_id;
+  uint32_t flags = test_only
+                       ? DRM_MODE_ATOMIC_TEST_ONLY
+                       : DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+  if (modeset_pending_) {
+    add_property(drm_connector_id_, drm_connector_properties_, "CRTC_ID",
+                 crtc_id);
+    add_property(crtc_id, drm_crtc_properties_, "MODE_ID", drm_mode_blob_id_);
+    add_property(crtc_id, drm_crtc_properties_, "ACTIVE", 1);
+    flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
+  }
+
+  // The source coordinates are in 16.16 fixed point.
+  uint64_t width = gbm_bo_get_width(fb.bo);
+  uint64_t height = gbm_bo_get_height(fb.bo);
+  add_property(drm_plane_id_, drm_plane_properties_, "FB_ID", fb.id);
+  add_property(drm_plane_id_, drm_plane_properties_, "CRTC_ID", crtc_id);
+  add_property(drm_plane_id_, drm_plane_properties_, "SRC_X", 0);
+  add_property(drm_plane_id_, drm_plane_properties_, "SRC_Y", 0);
+  add_property(drm_plane_id_, drm_plane_properties_, "SRC_W", width << 16);
+  add_property(drm_plane_id_, drm_plane_properties_, "SRC_H", height << 16);
+  add_property(drm_plane_id_, drm_plane_properties_, "CRTC_X", 0);
+  add_property(drm_plane_id_, drm_plane_properties_, "CRTC_Y", 0);
+  add_property(drm_plane_id_, drm_plane_properties_, "CRTC_W",
+               drm_mode_info_.hdisplay);
+  add_property(drm_plane_id_, drm_plane_properties_, "CRTC_H",
+               drm_mode_info_.vdisplay);
+
+  auto result = drmModeAtomicCommit(drm_device_, request, flags,
+                                    static_cast<NativeWindowDrm*>(this));
+  drmModeAtomicFree(request);
+  if (test_only) {
+    return result == 0;
+  }
+  if (result != 0) {
+    WAFFLE_LOG(ERROR) << "Failed to commit atomically. (" << result << ")";
+    return false;
+  }
+  modeset_pending_ = false;
+  return true;
+}
+
+void NativeWindowDrmGbm::OnPageFlip() {
+  // The pending buffer is on the display now, and the previous one is no
+  // longer read by the display controller.
+  ReleaseFramebuffer(front_fb_);
+  front_fb_ = pending_fb_;
+  pending_fb_ = Framebuffer();
+}
+
+uint32_t NativeWindowDrmGbm::GetFramebufferId(gbm_bo* bo, uint32_t format) {
+  auto* cached = static_cast<BoFramebuffer*>(gbm_bo_get_user_data(bo));
+  if (cached) {
+    return cached->id;
+  }
+
+  uint32_t handles[4] = {0};
+  uint32_t pitches[4] = {0};
+  uint32_t offsets[4] = {0};
+  uint64_t modifiers[4] = {0};
+  auto modifier = gbm_bo_get_modifier(bo);
+  for (int i = 0; i < gbm_bo_get_plane_count(bo); i++) {
+    handles[i] = gbm_bo_get_handle_for_plane(bo, i).u32;
+    pitches[i] = gbm_bo_get_stride_for_plane(bo, i);
+    offsets[i] = gbm_bo_get_offset(bo, i);
+    modifiers[i] = modifier;
+  }
+
+  uint32_t id;
+  int result;
+  if (modifier != kDmabufModifierInvalid) {
+    result = drmModeAddFB2WithModifiers(
+        drm_device_, gbm_bo_get_width(bo), gbm_bo_get_height(bo), format,
+        handles, pitches, offsets, modifiers, &id, DRM_MODE_FB_MODIFIERS);
+  } else {
+    result = drmModeAddFB2(drm_device_, gbm_bo_get_width(bo),
+                           gbm_bo_get_height(bo), format, handles, pitches,
+                           offsets, &id, 0);
   }
+  if (result != 0) {
+    WAFFLE_LOG(ERROR) << "Failed to add a framebuffer. (" << result << ")";
+    return 0;
+  }
+
+  gbm_bo_set_user_data(
+      bo, new BoFramebuffer{drm_device_, id}, [](gbm_bo* bo, void* data) {
+        auto* fb = static_cast<BoFramebuffer*>(data);
+        drmModeRmFB(fb->drm_device, fb->id);
+        delete fb;
+      });
+  return id;
+}
 
-  if (gbm_previous_bo_) {
-    drmModeRmFB(drm_device_, gbm_previous_fb_);
-    gbm_surface_release_buffer(static_cast<gbm_surface*>(window_),
-                               gbm_previous_bo_);
+void NativeWindowDrmGbm::ReleaseFramebuffer(Framebuffer& fb) {
+  if (!fb.bo) {
+    return;
+  }
+  // The framebuffer is removed together with the gbm_bo. Client buffers are
+  // kept in |scanout_imports_| for the next frames.
+  if (fb.scanout) {
+    if (fb.destroy_bo) {
+      gbm_bo_destroy(fb.bo);
+    }
+  } else {
+    gbm_surface_release_buffer(static_cast<gbm_surface*>(window_), fb.bo);
+  }
+  fb = Framebuffer();
+}
+
+NativeWindowDrmGbm::ScanoutImport* NativeWindowDrmGbm::GetScanoutImport(
+    wl_resource* buffer,
+    const DmabufAttributes& attributes) {
+  auto itr = scanout_imports_.find(buffer);
+  if (itr != scanout_imports_.end()) {
+    return itr->second->bo ? itr->second.get() : nullptr;
+  }
+
+  auto import = std::make_unique<ScanoutImport>();
+  import->window = this;
+  import->buffer = buffer;
+  import->destroy_listener.notify = +[](wl_listener* listener, void* data) {
+    ScanoutImport* import = wl_container_of(listener, import, destroy_listener);
+    import->window->DestroyScanoutImport(import);
+  };
+  wl_resource_add_destroy_listener(buffer, &import->destroy_listener);
+  auto* result = import.get();
+  scanout_imports_[buffer] = std::move(import);
+
+  auto format = std::make_pair(attributes.format, attributes.planes[0].modifier);
+  if (rejected_scanout_formats_.count(format)) {
+    return nullptr;
+  }
+
+  gbm_import_fd_modifier_data data = {};
+  data.width = attributes.width;
+  data.height = attributes.height;
+  data.format = attributes.format;
+  data.num_fds = attributes.num_planes;
+  data.modifier = attributes.planes[0].modifier;
+  for (int i = 0; i < attributes.num_planes; i++) {
+    data.fds[i] = attributes.planes[i].fd;
+    data.strides[i] = attributes.planes[i].stride;
+    data.offsets[i] = attributes.planes[i].offset;
+  }
+  auto* bo = gbm_bo_import(gbm_device_, GBM_BO_IMPORT_FD_MODIFIER, &data,
+                           GBM_BO_USE_SCANOUT);
+  if (!bo) {
+    WAFFLE_LOG(TRACE) << "The buffer can't be imported for scanout.";
+    return nullptr;
+  }
+
+  auto fb_id = GetFramebufferId(bo, attributes.format);
+  if (!fb_id) {
+    gbm_bo_destroy(bo);
+    RejectScanout(result, attributes);
+    return nullptr;
+  }
+  result->bo = bo;
+  result->fb_id = fb_id;
+
+  // Check once that the primary plane accepts the buffer, so that the real
+  // commits of it don't fail in every frame.
+  Framebuffer scanout_fb = {.bo = bo, .id = fb_id, .scanout = true};
+  if (atomic_modesetting_ && !CommitAtomic(scanout_fb, true)) {
+    RejectScanout(result, attributes);
+    return nullptr;
+  }
+  return result;
+}
+
+void NativeWindowDrmGbm::RejectScanout(ScanoutImport* import,
+                                       const DmabufAttributes& attributes) {
+  WAFFLE_LOG(TRACE) << "The buffer of format " << attributes.format
+                    << " can't be scanned out.";
+  rejected_scanout_formats_.emplace(attributes.format,
+                                    attributes.planes[0].modifier);
+  DestroyScanoutBo(import->bo);
+  import->bo = nullptr;
+  import->fb_id = 0;
+}
+
+void NativeWindowDrmGbm::DestroyScanoutImport(ScanoutImport* import) {
+  wl_list_remove(&import->destroy_listener.link);
+  DestroyScanoutBo(import->bo);
+  scanout_imports_.erase(import->buffer);
+}
+
+void NativeWindowDrmGbm::DestroyScanoutBo(gbm_bo* bo) {
+  // The display may still read the buffer. It's destroyed when it's replaced
+  // by the next frame then. The pending one is released later if both are
+  // the buffer.
+  if (!bo) {
+    return;
+  }
+  if (pending_fb_.bo == bo) {
+    pending_fb_.destroy_bo = true;
+  } else if (front_fb_.bo == bo) {
+    front_fb_.destroy_bo = true;
+  } else {
+    gbm_bo_destroy(bo);
   }
-  gbm_previous_bo_ = bo;
-  gbm_previous_fb_ = fb;
 }
 
 bool NativeWindowDrmGbm::CreateGbmSurface() {
@@ -10,7 +10,11 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 
+#include <memory>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #include "waffle/backend/window/native_window_drm.h"
 
@@ -44,15 +48,80 @@ class NativeWindowDrmGbm : public NativeWindowDrm {
   // |NativeWindow|
   void SwapBuffers() override;
 
+  // |NativeWindow|
+  bool ScanoutBuffer(wl_resource* buffer,
+                     const DmabufAttributes& attributes) override;
+
+  // |NativeWindow|
+  bool IsFlipPending() const override { return pending_fb_.bo != nullptr; }
+
+ protected:
+  // |NativeWindowDrm|
+  void OnPageFlip() override;
+
  private:
+  struct Framebuffer {
+    gbm_bo* bo = nullptr;
+    uint32_t id = 0;
+    // Whether |bo| is a client buffer which was imported for scanout instead
+    // of a buffer of the GBM surface.
+    bool scanout = false;
+    // Whether |bo| is destroyed when it's released. Imported client buffers
+    // are cached until their wl_buffers are destroyed, unless that happens
+    // while they are on the display.
+    bool destroy_bo = false;
+  };
+
+  // A client buffer imported for scanout. It's cached until the wl_buffer is
+  // destroyed so that the buffer isn't imported and added as a framebuffer
+  // again in every frame.
+  struct ScanoutImport;
+
+  // Shows |fb| on the display. With atomic modesetting, |fb| is queued until
+  // its page flip is completed. Returns false if |fb| can't be shown.
+  bool Present(const Framebuffer& fb);
+
+  // Commits |fb| to the primary plane without blocking. The completion is
+  // notified by a page flip event. If |test_only| is true, it only checks
+  // whether the display accepts |fb|.
+  bool CommitAtomic(const Framebuffer& fb, bool test_only = false);
+
+  // Returns the KMS framebuffer of |bo|. It's created only once per |bo| and
+  // cached as its user data. Returns 0 on failure.
+  uint32_t GetFramebufferId(gbm_bo* bo, uint32_t format);
+
+  void ReleaseFramebuffer(Framebuffer& fb);
+
+  // Returns the import of |buffer|, importing and testing it on the first
+  // call. Returns nullptr if the buffer can't be scanned out. The result is
+  // remembered until the buffer is destroyed.
+  ScanoutImport* GetScanoutImport(wl_resource* buffer,
+                                  const DmabufAttributes& attributes);
+
+  // Remembers that the display rejected |attributes|, so that other buffers
+  // of the same format and modifier aren't tried either.
+  void RejectScanout(ScanoutImport* import, const DmabufAttributes& attributes);
+
+  void DestroyScanoutImport(ScanoutImport* import);
+
+  // Destroys |bo| of a scanout import, or defers it while it's on the display.
+  void DestroyScanoutBo(gbm_bo* bo);
+
   bool CreateGbmSurface();
 
   bool CreateCursorBuffer(const std::string& cursor_name);
 
-  gbm_bo* gbm_previous_bo_ = nullptr;
-  uint32_t gbm_previous_fb_;
   gbm_device* gbm_device_ = nullptr;
   gbm_bo* gbm_cursor_bo_ = nullptr;
+  // The buffer on the display.
+  Framebuffer front_fb_;
+  // The buffer which waits for its page flip.
+  Framebuffer pending_fb_;
+  std::unordered_map<wl_resource*, std::unique_ptr<ScanoutImport>>
+      scanout_imports_;
+  // Pairs of the DRM format and the modifier which the primary plane
+  // rejected. e.g. most primary planes don't support YUV formats.
+  std::set<std::pair<uint32_t, uint64_t>> rejected_scanout_formats_;
 };
 
 }  // namespace waffle
@@ -7,6 +7,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -39,6 +40,28 @@ class WaffleWindow : public WindowBindingHandler {
     render_surface_->LoadIntoTexture(buffer, texture);
   }
 
+  std::vector<DmabufFormat> QueryDmabufFormats() const {
+    return render_surface_->QueryDmabufFormats();
+  }
+
+  bool LoadDmabufIntoTexture(wl_resource* buffer,
+                             const DmabufAttributes& attributes,
+                             Texture& texture) const {
+    return render_surface_->LoadDmabufIntoTexture(buffer, attributes, texture);
+  }
+
+  // Shows a client's dmabuf buffer on the display directly. Returns false when
+  // the backend can't scan out the buffer.
+  virtual bool ScanoutBuffer(wl_resource* buffer,
+                             const DmabufAttributes& attributes) {
+    return false;
+  }
+
+  // Whether the last frame is still waiting to be shown. When a backend
+  // returns true after a frame was submitted, it must notify
+  // WindowBindingHandlerDelegate::OnFramePresented() once the frame is shown.
+  virtual bool IsFramePending() const { return false; }
+
   // |WindowBindingHandler|
   void SetWindowBindingHandler(WindowBindingHandlerDelegate* window) override {
     binding_handler_delegate_ = window;
@@ -63,7 +86,16 @@ class WaffleWindow : public WindowBindingHandler {
   // |WindowBindingHandler|
   int32_t GetFrameRate() const override { return current_fps_; }
 
+  // |WindowBindingHandler|
+  FrameClock& GetFrameClock() override { return frame_clock_; }
+
  protected:
+  // Sets the refresh rate of the display in mHz.
+  void SetFrameRate(int32_t frame_rate) {
+    current_fps_ = frame_rate;
+    frame_clock_.SetFrameRate(frame_rate);
+  }
+
   uint32_t GetCurrentWidth() const { return window_properties_.width; }
   uint32_t GetCurrentHeight() const { return window_properties_.height; }
 
@@ -73,6 +105,7 @@ class WaffleWindow : public WindowBindingHandler {
   double pointer_x_ = 0;
   double pointer_y_ = 0;
   int32_t current_fps_ = 60000;
+  FrameClock frame_clock_;
   double current_scale_ = 1.0;
   std::string clipboard_data_ = "";
   std::unique_ptr<SurfaceGl> render_surface_;
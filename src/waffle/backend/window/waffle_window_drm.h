@@ -9,7 +9,6 @@
 #include <fcntl.h>
 #include <libinput.h>
 #include <linux/input-event-codes.h>
-#include <systemd/sd-event.h>
 #include <unistd.h>
 
 #include <chrono>
@@ -22,6 +21,7 @@
 #include "waffle/backend/window/native_window_drm_gbm.h"
 #include "waffle/backend/window/waffle_window.h"
 #include "waffle/logger.h"
+#include "waffle/wayland/wayland_event_source.h"
 
 namespace waffle {
 
@@ -61,33 +61,22 @@ class WaffleWindowDrm : public WaffleWindow {
       return;
     }
 
-    ret = sd_event_new(&libinput_event_loop_);
-    if (ret < 0) {
-      WAFFLE_LOG(ERROR) << "Failed to create libinput event loop.";
-      return;
-    }
-    ret =
-        sd_event_add_io(libinput_event_loop_, NULL, libinput_get_fd(libinput_),
-                        EPOLLIN | EPOLLRDHUP | EPOLLPRI, OnLibinputEvent, this);
-    if (ret < 0) {
+    if (!libinput_event_source_.AddFd(wl_display_, libinput_get_fd(libinput_),
+                                      OnLibinputEvent, this)) {
       WAFFLE_LOG(ERROR) << "Failed to listen for user input.";
-      libinput_event_loop_ = sd_event_unref(libinput_event_loop_);
       return;
     }
   }
 
   ~WaffleWindowDrm() {
-    if (udev_drm_event_loop_) {
-      sd_event_unref(udev_drm_event_loop_);
-    }
+    drm_event_source_.Remove();
+    udev_drm_event_source_.Remove();
+    libinput_event_source_.Remove();
 
     if (udev_monitor_) {
       udev_monitor_unref(udev_monitor_);
     }
 
-    if (libinput_event_loop_) {
-      sd_event_unref(libinput_event_loop_);
-    }
     libinput_unref(libinput_);
     display_valid_ = false;
   }
@@ -103,9 +92,7 @@ class WaffleWindowDrm : public WaffleWindow {
 
   // |WindowBindingHandler|
   bool DispatchEvent() override {
-    constexpr uint64_t kMaxWaitTime = 0;
-    sd_event_run(libinput_event_loop_, kMaxWaitTime);
-    sd_event_run(udev_drm_event_loop_, kMaxWaitTime);
+    // The events are dispatched by the sources of the wl_event_loop.
     return true;
   }
 
@@ -128,6 +115,13 @@ class WaffleWindowDrm : public WaffleWindow {
       WAFFLE_LOG(ERROR) << "Failed to register udev drm event loop.";
       return false;
     }
+
+    // Page flip events are delivered on the DRM device.
+    if (!drm_event_source_.AddFd(wl_display_, native_window_->DrmDevice(),
+                                 OnDrmEvent, this)) {
+      WAFFLE_LOG(ERROR) << "Failed to listen for drm event.";
+      return false;
+    }
     display_valid_ = true;
 
     render_surface_ = native_window_->CreateRenderSurface();
@@ -142,6 +136,7 @@ class WaffleWindowDrm : public WaffleWindow {
     }
     window_properties_.width = native_window_->Width();
     window_properties_.height = native_window_->Height();
+    SetFrameRate(native_window_->RefreshRate());
     WAFFLE_LOG(INFO) << "Display output resolution: "
                      << window_properties_.width << "x"
                      << window_properties_.height;
@@ -161,6 +156,17 @@ class WaffleWindowDrm : public WaffleWindow {
     native_window_ = nullptr;
   }
 
+  // |WaffleWindow|
+  bool ScanoutBuffer(wl_resource* buffer,
+                     const DmabufAttributes& attributes) override {
+    return native_window_->ScanoutBuffer(buffer, attributes);
+  }
+
+  // |WaffleWindow|
+  bool IsFramePending() const override {
+    return native_window_ && native_window_->IsFlipPending();
+  }
+
   // |WindowBindingHandler|
   std::string GetClipboardData() override { return clipboard_data_; }
 
@@ -232,14 +238,9 @@ class WaffleWindowDrm : public WaffleWindow {
     drm_device_id_ = std::atoi(sysnum);
     udev_unref(udev);
 
-    if (sd_event_new(&udev_drm_event_loop_) < 0) {
-      WAFFLE_LOG(ERROR) << "Failed to create udev drm event loop.";
-      return false;
-    }
-
-    if (sd_event_add_io(
-            udev_drm_event_loop_, NULL, udev_monitor_get_fd(udev_monitor_),
-            EPOLLIN | EPOLLRDHUP | EPOLLPRI, OnUdevDrmEvent, this) < 0) {
+    if (!udev_drm_event_source_.AddFd(wl_display_,
+                                      udev_monitor_get_fd(udev_monitor_),
+                                      OnUdevDrmEvent, this)) {
       WAFFLE_LOG(ERROR) << "Failed to listen for udev drm event.";
       return false;
     }
@@ -252,10 +253,7 @@ class WaffleWindowDrm : public WaffleWindow {
     return true;
   }
 
-  static int OnUdevDrmEvent(sd_event_source* source,
-                            int fd,
-                            uint32_t revents,
-                            void* data) {
+  static int OnUdevDrmEvent(int fd, uint32_t mask, void* data) {
     auto self = reinterpret_cast<WaffleWindowDrm*>(data);
     auto device = udev_monitor_receive_device(self->udev_monitor_);
     if (!device) {
@@ -265,6 +263,7 @@ class WaffleWindowDrm : public WaffleWindow {
 
     if (self->IsUdevEventHotplug(*device) &&
         self->native_window_->ConfigureDisplay(self->current_rotation_)) {
+      self->SetFrameRate(self->native_window_->RefreshRate());
       auto width = self->native_window_->Width();
       auto height = self->native_window_->Height();
       if (self->current_rotation_ == 90 || self->current_rotation_ == 270) {
@@ -281,6 +280,9 @@ class WaffleWindowDrm : public WaffleWindow {
           self->binding_handler_delegate_->OnWindowSizeChanged(
               self->window_properties_.width, self->window_properties_.height);
         }
+      } else if (self->binding_handler_delegate_) {
+        // The display was reconnected. Its contents need to be redrawn.
+        self->binding_handler_delegate_->OnWindowExposed();
       }
     }
 
@@ -288,6 +290,23 @@ class WaffleWindowDrm : public WaffleWindow {
     return 0;
   }
 
+  static int OnDrmEvent(int fd, uint32_t mask, void* data) {
+    auto self = reinterpret_cast<WaffleWindowDrm*>(data);
+    if (!self->native_window_) {
+      return 0;
+    }
+
+    if (!self->native_window_->DispatchDrmEvent()) {
+      return 0;
+    }
+
+    self->frame_clock_.Presented(self->native_window_->LastPageFlip());
+    if (self->binding_handler_delegate_) {
+      self->binding_handler_delegate_->OnFramePresented();
+    }
+    return 0;
+  }
+
   bool IsUdevEventHotplug(udev_device& device) {
     auto sysnum = udev_device_get_sysnum(&device);
     if (!sysnum) {
@@ -310,10 +329,7 @@ class WaffleWindowDrm : public WaffleWindow {
     return std::strcmp(value, kPropertyOn) == 0;
   }
 
-  static int OnLibinputEvent(sd_event_source* source,
-                             int fd,
-                             uint32_t revents,
-                             void* data) {
+  static int OnLibinputEvent(int fd, uint32_t mask, void* data) {
     auto self = reinterpret_cast<WaffleWindowDrm*>(data);
     auto ret = libinput_dispatch(self->libinput_);
     if (ret < 0) {
@@ -421,8 +437,9 @@ class WaffleWindowDrm : public WaffleWindow {
       auto evdev_keycode =
           static_cast<uint16_t>(libinput_event_keyboard_get_key(key_event));
       auto key_state = libinput_event_keyboard_get_key_state(key_event);
-      binding_handler_delegate_->OnKey(evdev_keycode,
-                                       key_state == LIBINPUT_KEY_STATE_PRESSED);
+      binding_handler_delegate_->OnKey(
+          libinput_event_keyboard_get_time_usec(key_event), evdev_keycode,
+          key_state == LIBINPUT_KEY_STATE_PRESSED);
     }
   }
 
@@ -436,6 +453,7 @@ class WaffleWindowDrm : public WaffleWindow {
       }
 
       auto pointer_event = libinput_event_get_pointer_event(event);
+      auto time_usec = libinput_event_pointer_get_time_usec(pointer_event);
       auto dx = libinput_event_pointer_get_dx(pointer_event);
       auto dy = libinput_event_pointer_get_dy(pointer_event);
 
@@ -446,7 +464,12 @@ class WaffleWindowDrm : public WaffleWindow {
       new_pointer_y = std::max(0.0, new_pointer_y);
       new_pointer_y = std::min(static_cast<double>(height - 1), new_pointer_y);
 
-      binding_handler_delegate_->OnPointerMove(new_pointer_x, new_pointer_y);
+      binding_handler_delegate_->OnPointerRelativeMotion(
+          time_usec, dx, dy,
+          libinput_event_pointer_get_dx_unaccelerated(pointer_event),
+          libinput_event_pointer_get_dy_unaccelerated(pointer_event));
+      binding_handler_delegate_->OnPointerMove(time_usec, new_pointer_x,
+                                               new_pointer_y);
       pointer_x_ = new_pointer_x;
       pointer_y_ = new_pointer_y;
     }
@@ -467,7 +490,8 @@ class WaffleWindowDrm : public WaffleWindow {
       auto y = libinput_event_pointer_get_absolute_y_transformed(pointer_event,
                                                                  height);
 
-      binding_handler_delegate_->OnPointerMove(x, y);
+      binding_handler_delegate_->OnPointerMove(
+          libinput_event_pointer_get_time_usec(pointer_event), x, y);
       pointer_x_ = x;
       pointer_y_ = y;
     }
@@ -479,12 +503,13 @@ class WaffleWindowDrm : public WaffleWindow {
       auto pointer_event = libinput_event_get_pointer_event(event);
       auto button = libinput_event_pointer_get_button(pointer_event);
       auto state = libinput_event_pointer_get_button_state(pointer_event);
+      auto time_usec = libinput_event_pointer_get_time_usec(pointer_event);
       if (state == LIBINPUT_BUTTON_STATE_PRESSED) {
-        binding_handler_delegate_->OnPointerButton(pointer_x_, pointer_y_,
-                                                   button, true);
+        binding_handler_delegate_->OnPointerButton(time_usec, pointer_x_,
+                                                   pointer_y_, button, true);
       } else {
-        binding_handler_delegate_->OnPointerButton(pointer_x_, pointer_y_,
-                                                   button, false);
+        binding_handler_delegate_->OnPointerButton(time_usec, pointer_x_,
+                                                   pointer_y_, button, false);
       }
     }
   }
@@ -541,20 +566,20 @@ class WaffleWindowDrm : public WaffleWindow {
       }
 
       auto touch_event = libinput_event_get_touch_event(event);
-      auto time = libinput_event_touch_get_time(touch_event);
+      auto time_usec = libinput_event_touch_get_time_usec(touch_event);
       auto slot = libinput_event_touch_get_seat_slot(touch_event);
       auto x = libinput_event_touch_get_x_transformed(touch_event, width);
       auto y = libinput_event_touch_get_y_transformed(touch_event, height);
-      binding_handler_delegate_->OnTouchDown(time, slot, x, y);
+      binding_handler_delegate_->OnTouchDown(time_usec, slot, x, y);
     }
   }
 
   void OnTouchUp(libinput_event* event) {
     if (binding_handler_delegate_) {
       auto touch_event = libinput_event_get_touch_event(event);
-      auto time = libinput_event_touch_get_time(touch_event);
+      auto time_usec = libinput_event_touch_get_time_usec(touch_event);
       auto slot = libinput_event_touch_get_seat_slot(touch_event);
-      binding_handler_delegate_->OnTouchUp(time, slot);
+      binding_handler_delegate_->OnTouchUp(time_usec, slot);
     }
   }
 
@@ -567,11 +592,11 @@ class WaffleWindowDrm : public WaffleWindow {
       }
 
       auto touch_event = libinput_event_get_touch_event(event);
-      auto time = libinput_event_touch_get_time(touch_event);
+      auto time_usec = libinput_event_touch_get_time_usec(touch_event);
       auto slot = libinput_event_touch_get_seat_slot(touch_event);
       auto x = libinput_event_touch_get_x_transformed(touch_event, width);
       auto y = libinput_event_touch_get_y_transformed(touch_event, height);
-      binding_handler_delegate_->OnTouchMotion(time, slot, x, y);
+      binding_handler_delegate_->OnTouchMotion(time_usec, slot, x, y);
     }
   }
 
@@ -622,13 +647,14 @@ class WaffleWindowDrm : public WaffleWindow {
 
   bool display_valid_;
   bool is_pending_cursor_add_event_;
-  sd_event* libinput_event_loop_;
+  WaylandEventSource libinput_event_source_;
   libinput* libinput_;
   std::unordered_map<size_t, std::unique_ptr<LibinputDeviceData>>
       libinput_devices_;
   int libinput_pointer_devices_ = 0;
 
-  sd_event* udev_drm_event_loop_ = nullptr;
+  WaylandEventSource udev_drm_event_source_;
+  WaylandEventSource drm_event_source_;
   udev_monitor* udev_monitor_ = nullptr;
   int drm_device_id_;
 };
@@ -34,6 +34,11 @@ uint32_t GetLinuxButtonValue(uint32_t x11_button) {
       return BTN_EXTRA;
   }
 }
+
+// X server timestamps are in milliseconds of CLOCK_MONOTONIC.
+uint64_t ToTimeUsec(Time time) {
+  return static_cast<uint64_t>(time) * 1000;
+}
 }  // namespace
 
 WaffleWindowX11::WaffleWindowX11(wl_display* wl_display,
@@ -48,11 +53,25 @@ WaffleWindowX11::WaffleWindowX11(wl_display* wl_display,
     return;
   }
 
+  // Events which were already read into the queue of Xlib don't wake up the
+  // loop, so DispatchEvent() also needs to be called before it blocks.
+  if (!x11_event_source_.AddFd(
+          wl_display_, XConnectionNumber(display_),
+          [](int fd, uint32_t mask, void* data) -> int {
+            reinterpret_cast<WaffleWindowX11*>(data)->DispatchEvent();
+            return 0;
+          },
+          this)) {
+    WAFFLE_LOG(ERROR) << "Failed to listen for X11 events.";
+    return;
+  }
+
   display_valid_ = true;
 }
 
 WaffleWindowX11::~WaffleWindowX11() {
   display_valid_ = false;
+  x11_event_source_.Remove();
   if (display_) {
     XSetCloseDownMode(display_, DestroyAll);
     XCloseDisplay(display_);
@@ -72,11 +91,17 @@ bool WaffleWindowX11::DispatchEvent() {
     XEvent event;
     XNextEvent(display_, &event);
     switch (event.type) {
+      case Expose:
+        if (binding_handler_delegate_ && event.xexpose.count == 0) {
+          binding_handler_delegate_->OnWindowExposed();
+        }
+        break;
       case EnterNotify:
       case MotionNotify:
         if (binding_handler_delegate_) {
-          binding_handler_delegate_->OnPointerMove(event.xbutton.x,
-                                                   event.xbutton.y);
+          binding_handler_delegate_->OnPointerMove(
+              ToTimeUsec(event.xbutton.time), event.xbutton.x,
+              event.xbutton.y);
         }
         break;
       case LeaveNotify:
@@ -86,24 +111,28 @@ bool WaffleWindowX11::DispatchEvent() {
         break;
       case ButtonPress: {
         constexpr bool button_pressed = true;
-        HandlePointerButtonEvent(event.xbutton.button, button_pressed,
-                                 event.xbutton.x, event.xbutton.y);
+        HandlePointerButtonEvent(event.xbutton.time, event.xbutton.button,
+                                 button_pressed, event.xbutton.x,
+                                 event.xbutton.y);
       } break;
       case ButtonRelease: {
         constexpr bool button_pressed = false;
-        HandlePointerButtonEvent(event.xbutton.button, button_pressed,
-                                 event.xbutton.x, event.xbutton.y);
+        HandlePointerButtonEvent(event.xbutton.time, event.xbutton.button,
+                                 button_pressed, event.xbutton.x,
+                                 event.xbutton.y);
       } break;
       case KeyPress:
         if (binding_handler_delegate_) {
           constexpr bool pressed = true;
-          binding_handler_delegate_->OnKey(event.xkey.keycode - 8, pressed);
+          binding_handler_delegate_->OnKey(ToTimeUsec(event.xkey.time),
+                                           event.xkey.keycode - 8, pressed);
         }
         break;
       case KeyRelease:
         if (binding_handler_delegate_) {
           constexpr bool pressed = false;
-          binding_handler_delegate_->OnKey(event.xkey.keycode - 8, pressed);
+          binding_handler_delegate_->OnKey(ToTimeUsec(event.xkey.time),
+                                           event.xkey.keycode - 8, pressed);
         }
         break;
       case ConfigureNotify: {
@@ -156,8 +185,6 @@ bool WaffleWindowX11::CreateRenderSurface(int32_t width, int32_t height) {
   render_surface_->GLContextMakeCurrent();
 
   render_surface_->BindWlDisplay(wl_display_);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   return true;
 }
@@ -178,7 +205,8 @@ void WaffleWindowX11::SetClipboardData(const std::string& data) {
   clipboard_data_ = data;
 }
 
-void WaffleWindowX11::HandlePointerButtonEvent(uint32_t button,
+void WaffleWindowX11::HandlePointerButtonEvent(Time time,
+                                               uint32_t button,
                                                bool button_pressed,
                                                int16_t x,
                                                int16_t y) {
@@ -216,11 +244,11 @@ void WaffleWindowX11::HandlePointerButtonEvent(uint32_t button,
     }
 
     if (button_pressed) {
-      binding_handler_delegate_->OnPointerButton(x, y, waffle_button,
-                                                 button_pressed);
+      binding_handler_delegate_->OnPointerButton(ToTimeUsec(time), x, y,
+                                                 waffle_button, button_pressed);
     } else {
-      binding_handler_delegate_->OnPointerButton(x, y, waffle_button,
-                                                 button_pressed);
+      binding_handler_delegate_->OnPointerButton(ToTimeUsec(time), x, y,
+                                                 waffle_button, button_pressed);
     }
   }
 }
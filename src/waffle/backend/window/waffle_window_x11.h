@@ -12,6 +12,7 @@
 #include "waffle/backend/window/native_window_x11.h"
 #include "waffle/backend/window/waffle_window.h"
 #include "waffle/backend/window/window_binding_handler.h"
+#include "waffle/wayland/wayland_event_source.h"
 
 namespace waffle {
 
@@ -41,12 +42,14 @@ class WaffleWindowX11 : public WaffleWindow {
 
  private:
   // Handles the events of the mouse button.
-  void HandlePointerButtonEvent(uint32_t button,
+  void HandlePointerButtonEvent(Time time,
+                                uint32_t button,
                                 bool button_pressed,
                                 int16_t x,
                                 int16_t y);
 
   Display* display_ = nullptr;
+  WaylandEventSource x11_event_source_;
   std::unique_ptr<NativeWindowX11> native_window_;
 };
 
@@ -9,6 +9,7 @@
 #include <variant>
 
 #include "waffle/backend/surface/surface_gl.h"
+#include "waffle/backend/window/frame_clock.h"
 #include "waffle/backend/window/window_binding_handler_delegate.h"
 #include "waffle/waffle_property.h"
 
@@ -48,6 +49,9 @@ class WindowBindingHandler {
   // Returns the frame rate of the display.
   virtual int32_t GetFrameRate() const = 0;
 
+  // Returns the clock which predicts the presentation timings of the display.
+  virtual FrameClock& GetFrameClock() = 0;
+
   // Returns the clipboard data.
   virtual std::string GetClipboardData() = 0;
 
@@ -5,29 +5,48 @@
 #ifndef WAFFLE_BACKEND_WINDOW_BINDING_HANDLER_DELEGATE_H_
 #define WAFFLE_BACKEND_WINDOW_BINDING_HANDLER_DELEGATE_H_
 
+#include <cstdint>
 #include <iostream>
 
 namespace waffle {
 
+// Input events carry |time_usec|, the timestamp of the input device in
+// microseconds of CLOCK_MONOTONIC.
 class WindowBindingHandlerDelegate {
  public:
-  virtual void OnWindowSizeChanged(size_t width, size_t height) const = 0;
-  virtual void OnPointerMove(double x, double y) = 0;
+  virtual void OnWindowSizeChanged(size_t width, size_t height) = 0;
+  virtual void OnWindowExposed() = 0;
+  virtual void OnFramePresented() = 0;
+  virtual void OnPointerMove(uint64_t time_usec, double x, double y) = 0;
+  // Reports a raw motion sample of a relative pointing device such as a
+  // mouse.
+  virtual void OnPointerRelativeMotion(uint64_t time_usec,
+                                       double dx,
+                                       double dy,
+                                       double dx_unaccel,
+                                       double dy_unaccel) = 0;
   virtual void OnPointerLeave() = 0;
-  virtual void OnPointerButton(double x,
+  virtual void OnPointerButton(uint64_t time_usec,
+                               double x,
                                double y,
                                uint32_t button,
                                bool pressed) = 0;
-  virtual void OnTouchDown(uint32_t time, int32_t id, double x, double y) = 0;
-  virtual void OnTouchUp(uint32_t time, int32_t id) = 0;
-  virtual void OnTouchMotion(uint32_t time, int32_t id, double x, double y) = 0;
+  virtual void OnTouchDown(uint64_t time_usec,
+                           int32_t id,
+                           double x,
+                           double y) = 0;
+  virtual void OnTouchUp(uint64_t time_usec, int32_t id) = 0;
+  virtual void OnTouchMotion(uint64_t time_usec,
+                             int32_t id,
+                             double x,
+                             double y) = 0;
   virtual void OnTouchCancel() = 0;
   virtual void OnKeyMap(uint32_t format, int fd, uint32_t size) = 0;
   virtual void OnKeyModifiers(uint32_t mods_depressed,
                               uint32_t mods_latched,
                               uint32_t mods_locked,
                               uint32_t group) = 0;
-  virtual void OnKey(uint32_t key, uint32_t state) = 0;
+  virtual void OnKey(uint64_t time_usec, uint32_t key, uint32_t state) = 0;
   virtual void OnScroll(double x,
                         double y,
                         double delta_x,
@@ -4,51 +4,96 @@
 
 #include "waffle/compositor/compositor.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <EGL/egl.h>
 #include <GLES3/gl32.h>
 
+#include "waffle/renderer/gl_procs.h"
+#include "waffle/wayland/wayland_seat.h"
+#include "waffle/wayland/wayland_surface.h"
+
 namespace waffle {
 
 namespace {
 
-struct GlProcs {
-  PFNGLVIEWPORTPROC glViewport;
-  bool valid;
+// todo: support different window size.
+constexpr double kWidth = 1920;
+constexpr double kHeight = 1024;
+
+// DRM fourcc formats which don't have an alpha channel.
+constexpr uint32_t kOpaqueDmabufFormats[] = {
+    0x34325258,  // XRGB8888
+    0x34324258,  // XBGR8888
+    0x30335258,  // XRGB2101010
+    0x30334258,  // XBGR2101010
+    0x36314752,  // RGB565
+    0x3231564e,  // NV12
+    0x32315559,  // YUV420
+    0x56595559,  // YUYV
 };
 
-static const GlProcs& GlProcs() {
-  static struct GlProcs procs = {};
-  static bool initialized = false;
-  if (!initialized) {
-    procs.glViewport =
-        reinterpret_cast<PFNGLVIEWPORTPROC>(eglGetProcAddress("glViewport"));
-    procs.valid = procs.glViewport;
-    if (!procs.valid) {
-      WAFFLE_LOG(ERROR) << "Failed to load GlProcs";
+bool IsOpaqueDmabufFormat(uint32_t format) {
+  for (auto opaque_format : kOpaqueDmabufFormats) {
+    if (format == opaque_format) {
+      return true;
     }
-    initialized = true;
   }
-  return procs;
+  return false;
 }
 
+// The number of the previous frames whose damage is kept to repair the back
+// buffer. The back buffer older than this is fully redrawn.
+constexpr size_t kMaxDamageHistory = 4;
+
+// The number of frames in a row in which a window must be unchanged to be
+// drawn into the static layer. Windows updating at a fraction of the refresh
+// rate would rebuild the layer every few frames otherwise.
+constexpr uint32_t kStaticLayerMinFrames = 3;
+
 }  // namespace
 
 Compositor* Compositor::instance_ = nullptr;
 
 Compositor::Compositor(wl_display* wl_display,
                        WaffleWindowProperties view_properties) {
+  scene_.AddChild(&toplevel_layer_);
+
   backend_ = std::make_unique<Backend>(wl_display, view_properties);
   backend_->SetWindowBindingHandler(this);
 
-  renderer_.Init();
-  bg_renderer_.Init();
+  repaint_timer_.AddTimer(
+      wl_display,
+      [](void* data) -> int {
+        reinterpret_cast<Compositor*>(data)->Draw();
+        return 0;
+      },
+      this);
+
+  hidden_frame_callback_interval_ = std::chrono::milliseconds(
+      view_properties.hidden_frame_callback_interval_ms);
+  hidden_frame_callback_timer_.AddTimer(
+      wl_display,
+      [](void* data) -> int {
+        reinterpret_cast<Compositor*>(data)->HandleHiddenFrameCallbacks();
+        return 0;
+      },
+      this);
+
+  batch_.Init();
 
   bg_texture_ = Texture();
   bg_texture_.LoadFileImage(view_properties.background_image_filepath);
+
+  auto bounds = backend_->GetPhysicalWindowBounds();
+  output_size_ = Vec2<int>(bounds.width, bounds.height);
+  DamageOutput();
+  ScheduleRepaint();
 }
 
 bool Compositor::HandleEvent() {
@@ -58,20 +103,44 @@ bool Compositor::HandleEvent() {
   return backend_->DispatchEvent();
 }
 
-Compositor::Window Compositor::ActiveWindow() {
-  for (auto w : windows_) {
-    if (!w.interface.expired()) {
-      return w;
+SceneNode* Compositor::ActiveWindow() {
+  return toplevel_layer_.BottomChild();
+}
+
+void Compositor::AddWindow(SceneNode* window) {
+  toplevel_layer_.AddChild(window);
+  hit_test_grid_dirty_ = true;
+  ScheduleRepaint();
+}
+
+void Compositor::RemoveWindow(SceneNode* window) {
+  if (pointer_focus_ == window) {
+    ClearPointerFocus();
+  }
+  if (keyboard_focus_ == window) {
+    if (auto input = window->Handler()->InputInterface().lock()) {
+      input->OnKeyboardLeave();
     }
+    keyboard_focus_ = nullptr;
+  }
+  for (auto itr = touch_focus_.begin(); itr != touch_focus_.end();) {
+    if (itr->second == window) {
+      itr = touch_focus_.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+
+  if (std::find(static_layer_nodes_.begin(), static_layer_nodes_.end(),
+                window) != static_layer_nodes_.end()) {
+    static_layer_nodes_.clear();
   }
-  return Window();
-}
 
-void Compositor::AddWindow(std::weak_ptr<WaylandBindingHandler> window) {
-  Window data;
-  data.interface = window;
-  data.pos = Vec2<int>(0, 0);
-  windows_.push_back(data);
+  // The area which the window occupied needs to be repainted.
+  output_damage_.Union(window->OutputRect());
+  window->Remove();
+  hit_test_grid_dirty_ = true;
+  ScheduleRepaint();
 }
 
 void Compositor::SetCursor(Texture texture) {
@@ -83,35 +152,537 @@ void Compositor::ClearCursor() {
   cursor_pos_ = Vec2<double>();
 }
 
-void Compositor::Draw() {
-  // todo: support different window size.
-  constexpr double kWidth = 1920;
-  constexpr double kHeight = 1024;
+void Compositor::ScheduleRepaint() {
+  if (repaint_state_ == RepaintState::kScheduled) {
+    return;
+  }
+  repaint_state_ = RepaintState::kScheduled;
+  UpdateRepaintTimer();
+}
 
-  bg_renderer_.Draw(bg_texture_, Vec2<int>(0, 0), Vec2<double>(1, 1));
+void Compositor::UpdateRepaintTimer() {
+  auto now = FrameClock::Clock::now();
+  auto repaint_time = NextRepaintTime(now);
+  if (repaint_time == FrameClock::Clock::time_point::max()) {
+    // The timer is armed again when the pending frame is presented.
+    repaint_timer_.Disarm();
+    return;
+  }
+  repaint_timer_.Arm(repaint_time - now);
+}
 
-  for (auto window : windows_) {
-    auto interface = window.interface.lock();
-    if (interface && interface->GetTexture().Valid()) {
-      auto texture = interface->GetTexture();
-      auto texture_size = texture.Size();
-      auto size =
-          Vec2<double>(texture_size.X() / kWidth, texture_size.Y() / kHeight);
-      renderer_.Draw(texture, window.pos, size);
-    }
+FrameClock::Clock::time_point Compositor::NextRepaintTime(
+    FrameClock::Clock::time_point now) const {
+  if (repaint_state_ == RepaintState::kIdle || backend_->IsFramePending()) {
+    return FrameClock::Clock::time_point::max();
+  }
+  return backend_->GetFrameClock().NextRepaintTime(now);
+}
+
+void Compositor::Draw() {
+  // Delivers the pointer motion since the last frame as a single event.
+  auto pointer_time_usec =
+      pointer_motion_pending_ ? pending_pointer_time_usec_ : 0;
+  FlushPointerMotion();
+
+  // The next frame can't be submitted until the previous one is shown. It's
+  // drawn after OnFramePresented() is called.
+  if (repaint_state_ == RepaintState::kIdle || backend_->IsFramePending()) {
+    return;
+  }
+  repaint_state_ = RepaintState::kIdle;
+
+  // Neither GL rendering nor buffer swapping is needed when nothing visible
+  // has changed. e.g. a client committed without any damage.
+  CollectDamage();
+  if (output_damage_.IsEmpty()) {
+    // The input delivered before this frame had no visible effect, e.g. a
+    // key press which the client ignored, so it must not be charged to an
+    // unrelated later frame. Only the pointer motion delivered just now may
+    // still get a response.
+    pending_input_time_usec_ = pointer_time_usec;
+
+    // No frame is presented, so the feedbacks of the content updates wait for
+    // the next one.
+    FrameDone();
+    return;
   }
 
-  // todo: support cursor.
-#if 0
-  if (cursor_texture_.Valid()) {
-    renderer_.Draw(cursor_texture_, cursor_pos_, Vec2<double>(0.03, 0.03));
+  if (TryScanout()) {
+    output_damage_.Clear();
+    FinishFrame();
+    return;
   }
+
+  auto damage = FrameRepaintRegion();
+
+  const auto& gl = GlProcs();
+  if (!damage.IsEmpty() && gl.valid) {
+    std::vector<SceneNode*> nodes;
+    scene_.ForEachBottomToTop([&nodes](SceneNode* node) {
+      if (node->Handler()) {
+        nodes.push_back(node);
+      }
+    });
+
+    // The windows in the static layer are already drawn in it, so only the
+    // ones above it are drawn over it.
+    auto num_static = UpdateStaticLayer(nodes);
+    auto& base = static_layer_ ? static_layer_->GetTexture() : bg_texture_;
+    std::vector<SceneNode*> dynamic_nodes(nodes.rbegin(),
+                                          nodes.rend() - num_static);
+
+    batch_.Begin(output_size_);
+    AddSceneQuads(dynamic_nodes, damage, base);
+
+    // todo: support cursor.
+#if 0
+    if (cursor_texture_.Valid()) {
+      auto size = cursor_texture_.Size();
+      batch_.Add(cursor_texture_,
+                 Rect<double>(cursor_pos_.X(), cursor_pos_.Y(), size.X(),
+                              size.Y()),
+                 Rect<double>(0, 0, 1, 1), true);
+    }
 #endif
 
+    batch_.Flush();
+  }
+
   backend_->SwapBuffer();
+  FinishFrame();
+}
+
+void Compositor::AddSceneQuads(const std::vector<SceneNode*>& nodes,
+                               const Region& region,
+                               Texture& base) {
+  // Walk the windows front to back to find the area where each of them is
+  // seen.
+  struct DrawItem {
+    Texture texture;
+    Vec2<int> pos;
+    Vec2<double> size;
+    Region opaque;
+    Region translucent;
+  };
+  std::vector<DrawItem> items;
+  auto uncovered = region;
+  for (auto* node : nodes) {
+    auto* interface = node->Handler();
+    if (!node->IsVisible() ||
+        !uncovered.Extents().Intersects(node->OutputRect()) ||
+        !interface->GetTexture().Valid()) {
+      continue;
+    }
+
+    auto visible = uncovered;
+    visible.Intersect(node->OutputRect());
+    if (visible.IsEmpty()) {
+      continue;
+    }
+
+    auto texture = interface->GetTexture();
+    auto texture_size = texture.Size();
+    auto size =
+        Vec2<double>(texture_size.X() / kWidth, texture_size.Y() / kHeight);
+    auto opaque = OutputOpaqueRegion(*node);
+    opaque.Intersect(visible);
+    auto translucent = visible;
+    translucent.Subtract(opaque);
+    uncovered.Subtract(opaque);
+    items.push_back(
+        {texture, node->OutputPosition(), size, opaque, translucent});
+  }
+
+  // Then draw back to front. Opaque parts don't need blending. All the
+  // quads are drawn by one call per window and blending.
+  AddQuads(base, Vec2<int>(0, 0), Vec2<double>(1, 1), uncovered, false);
+  for (auto itr = items.rbegin(); itr != items.rend(); ++itr) {
+    AddQuads(itr->texture, itr->pos, itr->size, itr->opaque, false);
+  }
+  for (auto itr = items.rbegin(); itr != items.rend(); ++itr) {
+    AddQuads(itr->texture, itr->pos, itr->size, itr->translucent, true);
+  }
+}
+
+size_t Compositor::UpdateStaticLayer(const std::vector<SceneNode*>& nodes) {
+  // Only the bottom windows are cached so that the layer can be drawn below
+  // all the others.
+  std::vector<SceneNode*> static_nodes;
+  for (auto* node : nodes) {
+    if (node->UnchangedFrames() < kStaticLayerMinFrames) {
+      break;
+    }
+    static_nodes.push_back(node);
+  }
+
+  if (static_nodes.empty()) {
+    render_targets_.Release(std::move(static_layer_));
+    static_layer_nodes_.clear();
+    return 0;
+  }
+
+  if (static_layer_) {
+    auto size = static_layer_->Size();
+    if (size.X() == output_size_.X() && size.Y() == output_size_.Y() &&
+        static_nodes == static_layer_nodes_) {
+      return static_nodes.size();
+    }
+    if (size.X() != output_size_.X() || size.Y() != output_size_.Y()) {
+      render_targets_.Release(std::move(static_layer_));
+    }
+  }
+  if (!static_layer_) {
+    static_layer_ = render_targets_.Acquire(output_size_);
+    if (!static_layer_->IsValid()) {
+      static_layer_.reset();
+      static_layer_nodes_.clear();
+      return 0;
+    }
+  }
+
+  // The layer is sampled like client buffers later, so it's drawn upside
+  // down.
+  static_layer_->Bind();
+  batch_.Begin(output_size_, true);
+  AddSceneQuads(
+      std::vector<SceneNode*>(static_nodes.rbegin(), static_nodes.rend()),
+      Region(Rect<int>(0, 0, output_size_.X(), output_size_.Y())),
+      bg_texture_);
+  batch_.Flush();
+  RenderTarget::Unbind();
+
+  static_layer_nodes_ = static_nodes;
+  return static_nodes.size();
+}
+
+void Compositor::MarkChanged(SceneNode& node) {
+  node.SetUnchangedFrames(0);
+  if (std::find(static_layer_nodes_.begin(), static_layer_nodes_.end(),
+                &node) != static_layer_nodes_.end()) {
+    static_layer_nodes_.clear();
+  }
+}
+
+void Compositor::FinishFrame() {
+  // The content updates committed so far are in this frame.
+  WaylandSurface::OnFrameSubmitted();
+  WaylandSurface::LatchPresentationFeedbacks();
+  frame_input_time_usec_ = pending_input_time_usec_;
+  pending_input_time_usec_ = 0;
+
+  // Backends which don't notify the presentation show the frame as soon as
+  // it's submitted. Its timestamp is not from the hardware then.
+  if (!backend_->IsFramePending()) {
+    FrameClock::Presentation presentation;
+    presentation.time = FrameClock::Clock::now();
+    backend_->GetFrameClock().Presented(presentation);
+    OnFramePresented();
+  }
+}
+
+void Compositor::FrameDone() {
+  const auto& clock = backend_->GetFrameClock();
+  if (frame_input_time_usec_ != 0) {
+    // Input timestamps and the presentation time are both CLOCK_MONOTONIC.
+    auto presentation_time_usec =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            clock.LastPresentation().time.time_since_epoch())
+            .count();
+    if (presentation_time_usec >= 0 &&
+        static_cast<uint64_t>(presentation_time_usec) >=
+            frame_input_time_usec_) {
+      input_latency_ = std::chrono::microseconds(presentation_time_usec -
+                                                 frame_input_time_usec_);
+      WAFFLE_LOG(TRACE) << "Input latency: " << input_latency_.count()
+                        << " us";
+    }
+    frame_input_time_usec_ = 0;
+  }
+
+  WaylandSurface::SendPresentationFeedbacks(clock, scanout_active_);
+  // Buffers replaced before this frame are no longer read by the display.
+  WaylandSurface::ReleaseRetiredBuffers();
+  // Clients can start drawing their next frames. The hidden ones are
+  // throttled since their frames aren't shown anyway.
+  WaylandSurface::HandleFrameCallbacks(FrameClock::Clock::now());
+  HandleHiddenFrameCallbacks();
+}
+
+void Compositor::HandleHiddenFrameCallbacks() {
+  auto now = FrameClock::Clock::now();
+  auto next_time = WaylandSurface::HandleHiddenFrameCallbacks(
+      now, hidden_frame_callback_interval_);
+  if (next_time == FrameClock::Clock::time_point::max()) {
+    hidden_frame_callback_timer_.Disarm();
+    return;
+  }
+  hidden_frame_callback_timer_.Arm(next_time - now);
+}
+
+bool Compositor::TryScanout() {
+  auto scanout = [this]() {
+    // Only the top window can be visible when it covers the whole output.
+    SceneNode* top = nullptr;
+    scene_.ForEachTopToBottom([&top](SceneNode* node) {
+      if (!top && node->Handler() && !node->OutputRect().IsEmpty()) {
+        top = node;
+      }
+    });
+    if (!top) {
+      return false;
+    }
+
+    auto* attributes = top->Handler()->GetDmabufAttributes();
+    auto output_rect = Rect<int>(0, 0, output_size_.X(), output_size_.Y());
+    if (!attributes || !IsOpaqueDmabufFormat(attributes->format) ||
+        !top->OutputRect().Contains(output_rect)) {
+      return false;
+    }
+    return backend_->ScanoutBuffer(top->Handler()->GetDmabufBuffer(),
+                                   *attributes);
+  }();
+
+  if (!scanout && scanout_active_) {
+    // The back buffers haven't been drawn while the client buffer was scanned
+    // out, so the whole output needs to be composited.
+    damage_history_.clear();
+    DamageOutput();
+  }
+  scanout_active_ = scanout;
+  return scanout;
+}
+
+void Compositor::CollectDamage() {
+  scene_.ForEachBottomToTop([this](SceneNode* node) {
+    auto* interface = node->Handler();
+    if (!interface) {
+      return;
+    }
+
+    auto pos = node->OutputPosition();
+    auto texture_size = interface->GetTexture().Size();
+    auto surface_rect = Rect<int>(0, 0, texture_size.X(), texture_size.Y());
+    auto output_rect = ToOutputRect(pos, texture_size, surface_rect);
+    auto changed = false;
+    if (output_rect != node->OutputRect()) {
+      // The window was resized or moved.
+      output_damage_.Union(node->OutputRect());
+      output_damage_.Union(output_rect);
+      node->SetOutputRect(output_rect);
+      node->SetSurfaceSize(texture_size);
+      hit_test_grid_dirty_ = true;
+      changed = true;
+    }
+
+    for (const auto& rect : interface->TakeDamage().Rects()) {
+      output_damage_.Union(ToOutputRect(pos, texture_size, rect));
+      changed = true;
+    }
+
+    if (changed) {
+      MarkChanged(*node);
+    } else if (node->UnchangedFrames() < kStaticLayerMinFrames) {
+      // It only needs to be counted up to the threshold.
+      node->SetUnchangedFrames(node->UnchangedFrames() + 1);
+    }
+  });
+  output_damage_.Intersect(Rect<int>(0, 0, output_size_.X(), output_size_.Y()));
+
+  UpdateVisibility();
+}
+
+void Compositor::UpdateVisibility() {
+  auto output_rect = Rect<int>(0, 0, output_size_.X(), output_size_.Y());
+  Region opaque;
+  scene_.ForEachTopToBottom([&](SceneNode* node) {
+    auto* interface = node->Handler();
+    if (!interface) {
+      return;
+    }
+
+    auto visible_rect = node->OutputRect().Intersect(output_rect);
+    auto visible = !visible_rect.IsEmpty() && !opaque.Contains(visible_rect);
+    if (visible != node->IsVisible()) {
+      MarkChanged(*node);
+      node->SetVisible(visible);
+      interface->SetVisible(visible);
+    }
+    if (visible) {
+      opaque.Union(OutputOpaqueRegion(*node));
+    }
+  });
+}
+
+Region Compositor::FrameRepaintRegion() {
+  // The back buffer holds the contents of |age| frames ago. So, the damage of
+  // the frames drawn since then needs to be redrawn as well.
+  auto damage = output_damage_;
+  auto age = static_cast<size_t>(backend_->GetBufferAge());
+  if (age == 0 || age > damage_history_.size() + 1) {
+    damage = Region(Rect<int>(0, 0, output_size_.X(), output_size_.Y()));
+  } else {
+    for (size_t i = 0; i + 1 < age; i++) {
+      damage.Union(damage_history_[i]);
+    }
+  }
+
+  damage_history_.push_front(output_damage_);
+  if (damage_history_.size() > kMaxDamageHistory) {
+    damage_history_.pop_back();
+  }
+  output_damage_.Clear();
+
+  return damage;
+}
+
+Vec2<double> Compositor::ToSurfacePosition(const SceneNode& node,
+                                           double x,
+                                           double y) const {
+  auto pos = node.OutputPosition();
+  auto surface_size = node.SurfaceSize();
+  return Vec2<double>(
+      (x / output_size_.X() - pos.X()) * kWidth,
+      surface_size.Y() - (1 - y / output_size_.Y() - pos.Y()) * kHeight);
+}
+
+SceneNode* Compositor::WindowAt(double x, double y, Vec2<double>& local) {
+  if (hit_test_grid_dirty_) {
+    UpdateHitTestGrid();
+  }
+
+  auto output_x = static_cast<int>(std::floor(x));
+  auto output_y = static_cast<int>(std::floor(y));
+  for (auto* node : hit_test_grid_.NodesAt(output_x, output_y)) {
+    if (!node->OutputRect().Contains(output_x, output_y)) {
+      continue;
+    }
+    auto pos = ToSurfacePosition(*node, x, y);
+    if (node->Handler()->AcceptsInput(pos)) {
+      local = pos;
+      return node;
+    }
+  }
+  return nullptr;
+}
+
+void Compositor::UpdateHitTestGrid() {
+  hit_test_grid_.Reset(output_size_);
+  scene_.ForEachTopToBottom([this](SceneNode* node) {
+    if (node->Handler() && !node->OutputRect().IsEmpty()) {
+      hit_test_grid_.Add(node, node->OutputRect());
+    }
+  });
+  hit_test_grid_dirty_ = false;
+}
+
+void Compositor::ClearPointerFocus() {
+  if (!pointer_focus_) {
+    return;
+  }
+  if (auto input = pointer_focus_->Handler()->InputInterface().lock()) {
+    input->OnPointerLeave();
+  }
+  pointer_focus_ = nullptr;
+}
+
+void Compositor::RecordInputTime(uint64_t time_usec) {
+  // The latency is measured from the oldest event which the frame responds
+  // to.
+  if (pending_input_time_usec_ == 0) {
+    pending_input_time_usec_ = time_usec;
+  }
+}
+
+Region Compositor::OutputOpaqueRegion(SceneNode& node) {
+  auto* interface = node.Handler();
+  auto texture_size = interface->GetTexture().Size();
+  auto* attributes = interface->GetDmabufAttributes();
+  auto opaque = attributes && IsOpaqueDmabufFormat(attributes->format)
+                    ? Region(Rect<int>(0, 0, texture_size.X(), texture_size.Y()))
+                    : interface->OpaqueRegion();
+
+  auto pos = node.OutputPosition();
+  Region region;
+  for (const auto& rect : opaque.Rects()) {
+    region.Union(ToOutputRect(pos, texture_size, rect, Rounding::kInwards));
+  }
+  return region;
+}
+
+void Compositor::AddQuads(Texture& texture,
+                          Vec2<int> pos,
+                          Vec2<double> size,
+                          const Region& region,
+                          bool blend) {
+  // The area of the whole texture in output pixels. See ToOutputRect.
+  auto left = pos.X() * output_size_.X();
+  auto right = (pos.X() + size.X()) * output_size_.X();
+  auto top = (1 - pos.Y() - size.Y()) * output_size_.Y();
+  auto bottom = (1 - pos.Y()) * output_size_.Y();
+  if (right <= left || bottom <= top) {
+    return;
+  }
+
+  // Each rectangle is clipped to the texture, so it's drawn without
+  // scissoring.
+  for (const auto& rect : region.Rects()) {
+    auto x0 = std::max<double>(rect.X(), left);
+    auto x1 = std::min<double>(rect.Right(), right);
+    auto y0 = std::max<double>(rect.Y(), top);
+    auto y1 = std::min<double>(rect.Bottom(), bottom);
+    if (x1 <= x0 || y1 <= y0) {
+      continue;
+    }
+    Rect<double> dest(x0, y0, x1 - x0, y1 - y0);
+    Rect<double> source((x0 - left) / (right - left),
+                        (y0 - top) / (bottom - top),
+                        (x1 - x0) / (right - left),
+                        (y1 - y0) / (bottom - top));
+    batch_.Add(texture, dest, source, blend);
+  }
+}
+
+Rect<int> Compositor::ToOutputRect(Vec2<int> pos,
+                                   Vec2<int> surface_size,
+                                   const Rect<int>& rect,
+                                   Rounding rounding) const {
+  // Windows are drawn in the normalized coordinates whose origin is the
+  // bottom-left corner of the output.
+  auto left = pos.X() + rect.X() / kWidth;
+  auto right = pos.X() + rect.Right() / kWidth;
+  auto top = pos.Y() + (surface_size.Y() - rect.Y()) / kHeight;
+  auto bottom = pos.Y() + (surface_size.Y() - rect.Bottom()) / kHeight;
+
+  auto round_down = [rounding](double value) {
+    return static_cast<int>(rounding == Rounding::kOutwards ? std::floor(value)
+                                                            : std::ceil(value));
+  };
+  auto round_up = [rounding](double value) {
+    return static_cast<int>(rounding == Rounding::kOutwards ? std::ceil(value)
+                                                            : std::floor(value));
+  };
+  auto x0 = round_down(left * output_size_.X());
+  auto x1 = round_up(right * output_size_.X());
+  auto y0 = round_down((1 - top) * output_size_.Y());
+  auto y1 = round_up((1 - bottom) * output_size_.Y());
+  if (x1 <= x0 || y1 <= y0) {
+    return Rect<int>();
+  }
+  return Rect<int>(x0, y0, x1 - x0, y1 - y0);
 }
 
-void Compositor::OnWindowSizeChanged(size_t width, size_t height) const {
+void Compositor::DamageOutput() {
+  output_damage_.Union(Rect<int>(0, 0, output_size_.X(), output_size_.Y()));
+}
+
+void Compositor::OnWindowSizeChanged(size_t width, size_t height) {
+  output_size_ = Vec2<int>(width, height);
+  hit_test_grid_dirty_ = true;
+  damage_history_.clear();
+  DamageOutput();
+  ScheduleRepaint();
+
   const auto& gl = GlProcs();
   if (!gl.valid) {
     return;
@@ -119,58 +690,163 @@ void Compositor::OnWindowSizeChanged(size_t width, size_t height) const {
   gl.glViewport(0, 0, width, height);
 }
 
-void Compositor::OnPointerMove(double x, double y) {
-  auto window = ActiveWindow();
-  if (auto interface = window.interface.lock()) {
-    auto input = interface->InputInterface().lock();
-    if (!input) {
-      return;
-    }
+void Compositor::OnWindowExposed() {
+  DamageOutput();
+  ScheduleRepaint();
+}
+
+void Compositor::OnFramePresented() {
+  FrameDone();
+  // Something was changed while the frame was waiting for its presentation.
+  UpdateRepaintTimer();
+}
+
+void Compositor::OnPointerMove(uint64_t time_usec, double x, double y) {
+  // Clients can't show more than one pointer position per frame, so motion
+  // is coalesced and delivered right before the next frame. The cursor is
+  // drawn by the backend for now (e.g. the DRM cursor plane), so this doesn't
+  // add any damage. Draw() returns without any GL work then.
+  RecordInputTime(time_usec);
+  pending_pointer_pos_ = Vec2<double>(x, y);
+  pending_pointer_time_usec_ = time_usec;
+  pointer_motion_pending_ = true;
+  ScheduleRepaint();
+}
+
+void Compositor::OnPointerRelativeMotion(uint64_t time_usec,
+                                         double dx,
+                                         double dy,
+                                         double dx_unaccel,
+                                         double dy_unaccel) {
+  // Clients which asked for relative motion get every raw sample. They are
+  // delivered with the coalesced motion, so that they go to the window under
+  // the pointer in the same wl_pointer frame.
+  RecordInputTime(time_usec);
+  pending_relative_motions_.push_back({time_usec, Vec2<double>(dx, dy),
+                                       Vec2<double>(dx_unaccel, dy_unaccel)});
+}
 
-    Vec2<double> pos(x, y);
-    cursor_pos_ = pos;
-    auto transformed =
-        Vec2<double>((pos.X() - window.pos.X()),   /// window.size.X(),
-                     (pos.Y() - window.pos.Y()));  // / window.size.Y());
-    input->OnPointerMove(transformed);
+void Compositor::FlushPointerMotion() {
+  if (!pointer_motion_pending_) {
+    return;
+  }
+  pointer_motion_pending_ = false;
+  std::vector<RelativeMotion> relative_motions;
+  std::swap(relative_motions, pending_relative_motions_);
+
+  auto x = pending_pointer_pos_.X();
+  auto y = pending_pointer_pos_.Y();
+  cursor_pos_ = pending_pointer_pos_;
+
+  // wl_pointer.enter is sent by the first motion on the new window.
+  Vec2<double> local;
+  auto* window = WindowAt(x, y, local);
+  if (window != pointer_focus_) {
+    ClearPointerFocus();
+    pointer_focus_ = window;
+  }
+  if (!window) {
+    return;
+  }
+
+  if (auto input = window->Handler()->InputInterface().lock()) {
+    input->OnPointerMove(pending_pointer_time_usec_, local);
+    for (const auto& motion : relative_motions) {
+      input->OnPointerRelativeMotion(motion.time_usec, motion.delta,
+                                     motion.delta_unaccel);
+    }
+    input->OnPointerFrame();
   }
 }
 
-void Compositor::OnPointerButton(double x,
+void Compositor::OnPointerButton(uint64_t time_usec,
+                                 double x,
                                  double y,
                                  uint32_t button,
                                  bool pressed) {
-  auto window = ActiveWindow();
-  if (auto interface = window.interface.lock()) {
-    auto input = interface->InputInterface().lock();
-    if (!input) {
-      return;
-    }
+  // The button is delivered after the motion before it.
+  FlushPointerMotion();
+  RecordInputTime(time_usec);
+  if (!pointer_focus_) {
+    return;
+  }
 
-    input->OnPointerClick(button, pressed);
+  if (auto input = pointer_focus_->Handler()->InputInterface().lock()) {
+    input->OnPointerClick(time_usec, button, pressed);
   }
 }
 
 void Compositor::OnPointerLeave() {
-  auto window = ActiveWindow();
-  if (auto interface = window.interface.lock()) {
-    auto input = interface->InputInterface().lock();
-    if (!input) {
-      return;
-    }
+  pointer_motion_pending_ = false;
+  pending_relative_motions_.clear();
+  ClearPointerFocus();
+  ClearCursor();
+}
 
-    input->OnPointerLeave();
-    ClearCursor();
+void Compositor::OnTouchDown(uint64_t time_usec,
+                             int32_t id,
+                             double x,
+                             double y) {
+  RecordInputTime(time_usec);
+  Vec2<double> local;
+  auto* window = WindowAt(x, y, local);
+  if (!window) {
+    return;
+  }
+
+  // The touch point keeps sending events to this window until it's up.
+  touch_focus_[id] = window;
+  if (auto input = window->Handler()->InputInterface().lock()) {
+    input->OnTouchDown(time_usec, id, local);
   }
 }
 
-void Compositor::OnTouchDown(uint32_t time, int32_t id, double x, double y) {}
+void Compositor::OnTouchUp(uint64_t time_usec, int32_t id) {
+  RecordInputTime(time_usec);
+  auto itr = touch_focus_.find(id);
+  if (itr == touch_focus_.end()) {
+    return;
+  }
 
-void Compositor::OnTouchUp(uint32_t time, int32_t id) {}
+  auto* window = itr->second;
+  touch_focus_.erase(itr);
+  if (auto input = window->Handler()->InputInterface().lock()) {
+    input->OnTouchUp(time_usec, id);
+  }
+}
 
-void Compositor::OnTouchMotion(uint32_t time, int32_t id, double x, double y) {}
+void Compositor::OnTouchMotion(uint64_t time_usec,
+                               int32_t id,
+                               double x,
+                               double y) {
+  RecordInputTime(time_usec);
+  auto itr = touch_focus_.find(id);
+  if (itr == touch_focus_.end()) {
+    return;
+  }
+
+  auto* window = itr->second;
+  if (auto input = window->Handler()->InputInterface().lock()) {
+    input->OnTouchMotion(time_usec, id, ToSurfacePosition(*window, x, y));
+  }
+}
 
-void Compositor::OnTouchCancel() {}
+void Compositor::OnTouchCancel() {
+  std::vector<SceneNode*> windows;
+  for (const auto& focus : touch_focus_) {
+    if (std::find(windows.begin(), windows.end(), focus.second) ==
+        windows.end()) {
+      windows.push_back(focus.second);
+    }
+  }
+  touch_focus_.clear();
+
+  for (auto* window : windows) {
+    if (auto input = window->Handler()->InputInterface().lock()) {
+      input->OnTouchCancel();
+    }
+  }
+}
 
 void Compositor::OnKeyMap(uint32_t format, int fd, uint32_t size) {}
 
@@ -179,14 +855,19 @@ void Compositor::OnKeyModifiers(uint32_t mods_depressed,
                                 uint32_t mods_locked,
                                 uint32_t group) {}
 
-void Compositor::OnKey(uint32_t key, uint32_t state) {
-  auto window = ActiveWindow();
-  if (auto interface = window.interface.lock()) {
-    auto input = interface->InputInterface().lock();
+void Compositor::OnKey(uint64_t time_usec, uint32_t key, uint32_t state) {
+  // Keys are not reordered with the pointer motion before them.
+  FlushPointerMotion();
+  RecordInputTime(time_usec);
+  WlSeat::UpdateKeyboardState(key, state);
+  auto* window = ActiveWindow();
+  if (window) {
+    auto input = window->Handler()->InputInterface().lock();
     if (!input) {
       return;
     }
-    input->OnKey(key, state);
+    keyboard_focus_ = window;
+    input->OnKey(time_usec, key, state);
   }
 }
 
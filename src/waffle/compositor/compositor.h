@@ -6,22 +6,26 @@
 #define WAFFLE_COMPOSITOR_COMPOSITOR_COMPOSITOR_H_
 
 #include <cassert>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
 #include <vector>
 
 #include "waffle/backend/backend.h"
-#include "waffle/renderer/window_renderer.h"
+#include "waffle/compositor/hit_test_grid.h"
+#include "waffle/compositor/scene_node.h"
+#include "waffle/renderer/quad_batch.h"
+#include "waffle/renderer/render_target.h"
+#include "waffle/utils/rect.h"
+#include "waffle/utils/region.h"
 #include "waffle/utils/vec2.h"
 #include "waffle/wayland/wayland_binding_handler.h"
+#include "waffle/wayland/wayland_event_source.h"
 
 namespace waffle {
 
 class Compositor : public WindowBindingHandlerDelegate {
  public:
-  struct Window {
-    std::weak_ptr<WaylandBindingHandler> interface;
-    Vec2<int> pos = Vec2<int>();
-  };
-
   Compositor(wl_display* wl_display, WaffleWindowProperties view_properties);
 
   static void Create(wl_display* wl_display,
@@ -45,26 +49,73 @@ class Compositor : public WindowBindingHandlerDelegate {
     backend_->LoadIntoTexture(buffer, texture);
   }
 
+  std::vector<DmabufFormat> QueryDmabufFormats() const {
+    return backend_->QueryDmabufFormats();
+  }
+
+  bool LoadDmabufIntoTexture(wl_resource* buffer,
+                             const DmabufAttributes& attributes,
+                             Texture& texture) const {
+    return backend_->LoadDmabufIntoTexture(buffer, attributes, texture);
+  }
+
   bool HandleEvent();
 
-  void AddWindow(std::weak_ptr<WaylandBindingHandler> window);
+  // Adds |window| on top of the other toplevels. |window| must be removed by
+  // RemoveWindow() before its surface is destroyed.
+  void AddWindow(SceneNode* window);
+
+  void RemoveWindow(SceneNode* window);
 
   void SetCursor(Texture texture);
 
   void ClearCursor();
 
+  // Requests the next frame to be drawn. Draw() does nothing until this is
+  // called.
+  void ScheduleRepaint();
+
+  bool NeedsRepaint() const { return repaint_state_ != RepaintState::kIdle; }
+
+  // Returns the time when Draw() needs to be called for the next frame. It's
+  // a little before the next vblank so that the frame is shown at the vblank.
+  // Returns FrameClock::Clock::time_point::max() if there is nothing to draw.
+  FrameClock::Clock::time_point NextRepaintTime(
+      FrameClock::Clock::time_point now) const;
+
+  // Draws the next frame. This is called by the repaint timer at
+  // NextRepaintTime().
   void Draw();
 
   int32_t GetFrameRate() const { return backend_->GetFrameRate(); }
 
+  // Returns the time from the oldest input event which was delivered before
+  // the last presented frame was submitted to its presentation. 0 if no frame
+  // has been presented after any input.
+  std::chrono::microseconds LastInputLatency() const { return input_latency_; }
+
   // |WindowBindingHandlerDelegate|
-  void OnWindowSizeChanged(size_t width, size_t height) const override;
+  void OnWindowSizeChanged(size_t width, size_t height) override;
 
   // |WindowBindingHandlerDelegate|
-  void OnPointerMove(double x, double y) override;
+  void OnWindowExposed() override;
 
   // |WindowBindingHandlerDelegate|
-  void OnPointerButton(double x,
+  void OnFramePresented() override;
+
+  // |WindowBindingHandlerDelegate|
+  void OnPointerMove(uint64_t time_usec, double x, double y) override;
+
+  // |WindowBindingHandlerDelegate|
+  void OnPointerRelativeMotion(uint64_t time_usec,
+                               double dx,
+                               double dy,
+                               double dx_unaccel,
+                               double dy_unaccel) override;
+
+  // |WindowBindingHandlerDelegate|
+  void OnPointerButton(uint64_t time_usec,
+                       double x,
                        double y,
                        uint32_t button,
                        bool pressed) override;
@@ -73,13 +124,19 @@ class Compositor : public WindowBindingHandlerDelegate {
   void OnPointerLeave() override;
 
   // |WindowBindingHandlerDelegate|
-  void OnTouchDown(uint32_t time, int32_t id, double x, double y) override;
+  void OnTouchDown(uint64_t time_usec,
+                   int32_t id,
+                   double x,
+                   double y) override;
 
   // |WindowBindingHandlerDelegate|
-  void OnTouchUp(uint32_t time, int32_t id) override;
+  void OnTouchUp(uint64_t time_usec, int32_t id) override;
 
   // |WindowBindingHandlerDelegate|
-  void OnTouchMotion(uint32_t time, int32_t id, double x, double y) override;
+  void OnTouchMotion(uint64_t time_usec,
+                     int32_t id,
+                     double x,
+                     double y) override;
 
   // |WindowBindingHandlerDelegate|
   void OnTouchCancel() override;
@@ -94,7 +151,7 @@ class Compositor : public WindowBindingHandlerDelegate {
                       uint32_t group) override;
 
   // |WindowBindingHandlerDelegate|
-  void OnKey(uint32_t key, uint32_t state) override;
+  void OnKey(uint64_t time_usec, uint32_t key, uint32_t state) override;
 
   // |WindowBindingHandlerDelegate|
   void OnScroll(double x,
@@ -110,15 +167,162 @@ class Compositor : public WindowBindingHandlerDelegate {
   static Compositor* instance_;
 
  private:
-  Compositor::Window ActiveWindow();
+  enum class RepaintState {
+    // Nothing has changed since the last frame.
+    kIdle,
+    // Something has changed, and the next frame needs to be drawn.
+    kScheduled,
+  };
+
+  enum class Rounding {
+    // Partially covered pixels are included. e.g. for damage.
+    kOutwards,
+    // Only fully covered pixels are included. e.g. for opaque areas.
+    kInwards,
+  };
+
+  SceneNode* ActiveWindow();
+
+  // Converts |rect| in the surface local coordinates to the output
+  // coordinates. |pos| and |surface_size| are the window position and the
+  // surface size.
+  Rect<int> ToOutputRect(Vec2<int> pos,
+                         Vec2<int> surface_size,
+                         const Rect<int>& rect,
+                         Rounding rounding = Rounding::kOutwards) const;
+
+  // Converts (|x|, |y|) in output coordinates to the surface local
+  // coordinates of |node|. This is the inverse of ToOutputRect.
+  Vec2<double> ToSurfacePosition(const SceneNode& node, double x, double y) const;
+
+  // Returns the top window which accepts input at (|x|, |y|) in output
+  // coordinates, or nullptr. |local| is set to the position in the surface
+  // local coordinates of the window.
+  SceneNode* WindowAt(double x, double y, Vec2<double>& local);
+
+  // Rebuilds |hit_test_grid_| from the scene.
+  void UpdateHitTestGrid();
+
+  // Sends the coalesced pointer motion and the raw samples since the last
+  // call to the window under the pointer, in one wl_pointer frame.
+  void FlushPointerMotion();
+
+  // Sends wl_pointer.leave to the window which has the pointer focus.
+  void ClearPointerFocus();
+
+  // Records the timestamp of an input event to measure the input latency.
+  void RecordInputTime(uint64_t time_usec);
+
+  // Returns the area where |node| hides the nodes below it, in output
+  // coordinates.
+  Region OutputOpaqueRegion(SceneNode& node);
+
+  // Adds the quads which draw |texture| only inside |region| in output
+  // coordinates to |batch_|.
+  void AddQuads(Texture& texture,
+                Vec2<int> pos,
+                Vec2<double> size,
+                const Region& region,
+                bool blend);
+
+  // Adds the quads which draw |nodes| (top to bottom) over |base| only inside
+  // |region| in output coordinates to |batch_|. The area covered by opaque
+  // windows is never drawn twice.
+  void AddSceneQuads(const std::vector<SceneNode*>& nodes,
+                     const Region& region,
+                     Texture& base);
+
+  // Draws the background and the bottom windows which haven't changed for a
+  // while (|nodes| is bottom to top) into |static_layer_|, unless it already
+  // has them. Returns the number of the windows in it. They don't need to be
+  // drawn again while they are unchanged.
+  size_t UpdateStaticLayer(const std::vector<SceneNode*>& nodes);
+
+  // Resets the unchanged frames of |node|, and drops it from |static_layer_|.
+  void MarkChanged(SceneNode& node);
+
+  // Collects the damage of all windows for the current frame.
+  void CollectDamage();
+
+  // Updates whether each window is visible. A window is hidden when it's out
+  // of the output or covered by the opaque regions of the windows above it.
+  void UpdateVisibility();
+
+  // Sends the frame callbacks of the hidden surfaces which are due, and arms
+  // the timer for the next ones.
+  void HandleHiddenFrameCallbacks();
+
+  // Returns the area which needs to be redrawn in the current back buffer.
+  Region FrameRepaintRegion();
+
+  // Marks the whole output as damaged.
+  void DamageOutput();
+
+  // Shows the buffer of the top window on the display directly when it
+  // covers the whole output with opaque contents. Returns false if the frame
+  // needs to be composited.
+  bool TryScanout();
+
+  // Completes the frame which was submitted to the backend.
+  void FinishFrame();
+
+  // Called when the current frame is shown or there was nothing to draw.
+  void FrameDone();
+
+  // Arms the repaint timer for the next frame if it's needed.
+  void UpdateRepaintTimer();
 
   std::unique_ptr<Backend> backend_;
-  std::vector<Compositor::Window> windows_;
-  WindowRenderer renderer_;
-  WindowRenderer bg_renderer_;
+  // The root of the scene graph. Toplevels are in |toplevel_layer_|.
+  SceneNode scene_{SceneNode::Type::kOutput};
+  SceneNode toplevel_layer_{SceneNode::Type::kLayer};
+  // Index of the windows for input. It's rebuilt lazily when the windows
+  // were added, removed, moved or resized.
+  HitTestGrid hit_test_grid_;
+  bool hit_test_grid_dirty_ = true;
+  // The window which has the pointer focus.
+  SceneNode* pointer_focus_ = nullptr;
+  // The latest pointer position which is not delivered yet.
+  Vec2<double> pending_pointer_pos_;
+  uint64_t pending_pointer_time_usec_ = 0;
+  bool pointer_motion_pending_ = false;
+  // The raw motion samples which are not delivered yet.
+  struct RelativeMotion {
+    uint64_t time_usec;
+    Vec2<double> delta;
+    Vec2<double> delta_unaccel;
+  };
+  std::vector<RelativeMotion> pending_relative_motions_;
+  // The window which got the last key.
+  SceneNode* keyboard_focus_ = nullptr;
+  // The windows which got the touch points, keyed by the touch ids.
+  std::unordered_map<int32_t, SceneNode*> touch_focus_;
+  QuadBatch batch_;
   Texture bg_texture_;
   Texture cursor_texture_;
   Vec2<double> cursor_pos_;
+  RenderTargetPool render_targets_;
+  // The background and the bottom windows in |static_layer_nodes_| drawn in
+  // advance. nullptr if no window is static.
+  std::unique_ptr<RenderTarget> static_layer_;
+  std::vector<SceneNode*> static_layer_nodes_;
+  Vec2<int> output_size_;
+  // Damage which is not yet drawn, in output coordinates.
+  Region output_damage_;
+  // Damage of the previous frames. The front is the latest one. This is used
+  // to repair the back buffer depending on its age.
+  std::deque<Region> damage_history_;
+  RepaintState repaint_state_ = RepaintState::kIdle;
+  WaylandEventSource repaint_timer_;
+  std::chrono::nanoseconds hidden_frame_callback_interval_;
+  WaylandEventSource hidden_frame_callback_timer_;
+  // Whether a client buffer is scanned out instead of the composited frame.
+  bool scanout_active_ = false;
+  // Timestamps of the oldest input event which is not in any frame yet, and
+  // the one in the frame waiting for its presentation. 0 if there is none.
+  uint64_t pending_input_time_usec_ = 0;
+  uint64_t frame_input_time_usec_ = 0;
+  std::chrono::microseconds input_latency_{0};
 };
 
 };  // namespace waffle
@@ -0,0 +1,46 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/compositor/hit_test_grid.h"
+
+#include <algorithm>
+
+namespace waffle {
+
+void HitTestGrid::Reset(Vec2<int> output_size) {
+  columns_ = std::max(1, (output_size.X() + kCellSize - 1) / kCellSize);
+  rows_ = std::max(1, (output_size.Y() + kCellSize - 1) / kCellSize);
+  cells_.resize(columns_ * rows_);
+  for (auto& cell : cells_) {
+    cell.clear();
+  }
+}
+
+void HitTestGrid::Add(SceneNode* node, const Rect<int>& rect) {
+  auto bounds = rect.Intersect(
+      Rect<int>(0, 0, columns_ * kCellSize, rows_ * kCellSize));
+  if (bounds.IsEmpty()) {
+    return;
+  }
+
+  auto first_column = bounds.X() / kCellSize;
+  auto last_column = (bounds.Right() - 1) / kCellSize;
+  auto first_row = bounds.Y() / kCellSize;
+  auto last_row = (bounds.Bottom() - 1) / kCellSize;
+  for (auto row = first_row; row <= last_row; row++) {
+    for (auto column = first_column; column <= last_column; column++) {
+      cells_[row * columns_ + column].push_back(node);
+    }
+  }
+}
+
+const std::vector<SceneNode*>& HitTestGrid::NodesAt(int x, int y) const {
+  static const std::vector<SceneNode*> kEmpty;
+  if (x < 0 || y < 0 || x >= columns_ * kCellSize || y >= rows_ * kCellSize) {
+    return kEmpty;
+  }
+  return cells_[(y / kCellSize) * columns_ + x / kCellSize];
+}
+
+}  // namespace waffle
@@ -0,0 +1,46 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_COMPOSITOR_HIT_TEST_GRID_H_
+#define WAFFLE_COMPOSITOR_HIT_TEST_GRID_H_
+
+#include <vector>
+
+#include "waffle/compositor/scene_node.h"
+#include "waffle/utils/rect.h"
+#include "waffle/utils/vec2.h"
+
+namespace waffle {
+
+// A uniform grid over the output which indexes scene nodes by their bounds.
+// Each cell lists the nodes overlapping it from the top to the bottom, so a
+// lookup only tests the few nodes around the point however many windows
+// there are.
+class HitTestGrid {
+ public:
+  HitTestGrid() = default;
+  ~HitTestGrid() = default;
+
+  // Removes all nodes and covers an output of |output_size|.
+  void Reset(Vec2<int> output_size);
+
+  // Adds |node| occupying |rect| in output coordinates. Nodes need to be
+  // added from the top to the bottom.
+  void Add(SceneNode* node, const Rect<int>& rect);
+
+  // Returns the nodes which may contain (|x|, |y|), from the top to the
+  // bottom.
+  const std::vector<SceneNode*>& NodesAt(int x, int y) const;
+
+ private:
+  static constexpr int kCellSize = 128;
+
+  int columns_ = 0;
+  int rows_ = 0;
+  std::vector<std::vector<SceneNode*>> cells_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_COMPOSITOR_HIT_TEST_GRID_H_
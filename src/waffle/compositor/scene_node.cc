@@ -0,0 +1,74 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/compositor/scene_node.h"
+
+namespace waffle {
+
+SceneNode::SceneNode(Type type, WaylandBindingHandler* handler)
+    : type_(type), handler_(handler) {}
+
+SceneNode::~SceneNode() {
+  Remove();
+
+  // The children are left out of the scene.
+  auto* child = bottom_child_;
+  while (child) {
+    auto* above = child->above_;
+    child->parent_ = nullptr;
+    child->above_ = nullptr;
+    child->below_ = nullptr;
+    child = above;
+  }
+}
+
+void SceneNode::AddChild(SceneNode* child) {
+  child->Remove();
+
+  child->parent_ = this;
+  child->below_ = top_child_;
+  if (top_child_) {
+    top_child_->above_ = child;
+  } else {
+    bottom_child_ = child;
+  }
+  top_child_ = child;
+}
+
+void SceneNode::Remove() {
+  if (!parent_) {
+    return;
+  }
+
+  if (below_) {
+    below_->above_ = above_;
+  } else {
+    parent_->bottom_child_ = above_;
+  }
+  if (above_) {
+    above_->below_ = below_;
+  } else {
+    parent_->top_child_ = below_;
+  }
+  parent_ = nullptr;
+  above_ = nullptr;
+  below_ = nullptr;
+}
+
+void SceneNode::Raise() {
+  if (parent_ && parent_->top_child_ != this) {
+    parent_->AddChild(this);
+  }
+}
+
+Vec2<int> SceneNode::OutputPosition() const {
+  auto position = position_;
+  for (auto* node = parent_; node; node = node->parent_) {
+    position = Vec2<int>(position.X() + node->position_.X(),
+                         position.Y() + node->position_.Y());
+  }
+  return position;
+}
+
+}  // namespace waffle
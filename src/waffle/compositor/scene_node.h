@@ -0,0 +1,121 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_COMPOSITOR_SCENE_NODE_H_
+#define WAFFLE_COMPOSITOR_SCENE_NODE_H_
+
+#include <cstdint>
+
+#include "waffle/utils/rect.h"
+#include "waffle/utils/vec2.h"
+
+namespace waffle {
+
+class WaylandBindingHandler;
+
+// A node of the scene graph. The output is the root, and layers, toplevels
+// and subsurfaces are its descendants. Children are kept in an intrusive
+// list from the bottom to the top and are shown above their parent. So,
+// nodes are inserted, removed and raised in O(1) time without any
+// allocation. A node removes itself from the scene when it's destroyed.
+class SceneNode {
+ public:
+  enum class Type {
+    kOutput,
+    kLayer,
+    kToplevel,
+    kSubsurface,
+  };
+
+  explicit SceneNode(Type type, WaylandBindingHandler* handler = nullptr);
+  ~SceneNode();
+
+  // Prevent copying.
+  SceneNode(SceneNode const&) = delete;
+  SceneNode& operator=(SceneNode const&) = delete;
+
+  Type GetType() const { return type_; }
+
+  // Returns the surface shown by this node. nullptr for the output and layers.
+  WaylandBindingHandler* Handler() const { return handler_; }
+
+  SceneNode* Parent() const { return parent_; }
+  SceneNode* BottomChild() const { return bottom_child_; }
+  SceneNode* TopChild() const { return top_child_; }
+  SceneNode* SiblingAbove() const { return above_; }
+  SceneNode* SiblingBelow() const { return below_; }
+
+  // Adds |child| on top of the other children. |child| is removed from its
+  // current parent first.
+  void AddChild(SceneNode* child);
+
+  // Removes this node from its parent. The children stay with this node.
+  void Remove();
+
+  // Moves this node on top of its siblings.
+  void Raise();
+
+  // The position relative to the parent. See Compositor::ToOutputRect for
+  // the units.
+  Vec2<int> Position() const { return position_; }
+  void SetPosition(Vec2<int> position) { position_ = position; }
+
+  // Returns the position in the output, including the positions of the
+  // ancestors.
+  Vec2<int> OutputPosition() const;
+
+  // The area which the node occupied in the last frame, in output
+  // coordinates.
+  Rect<int> OutputRect() const { return output_rect_; }
+  void SetOutputRect(const Rect<int>& rect) { output_rect_ = rect; }
+
+  // The size of the surface in the last frame.
+  Vec2<int> SurfaceSize() const { return surface_size_; }
+  void SetSurfaceSize(Vec2<int> size) { surface_size_ = size; }
+
+  // Whether the node was seen in the last frame.
+  bool IsVisible() const { return visible_; }
+  void SetVisible(bool visible) { visible_ = visible; }
+
+  // The number of the last frames in a row in which the node was neither
+  // damaged, moved, resized nor shown or hidden.
+  uint32_t UnchangedFrames() const { return unchanged_frames_; }
+  void SetUnchangedFrames(uint32_t frames) { unchanged_frames_ = frames; }
+
+  // Calls |func| with each descendant from the bottom to the top.
+  template <typename Func>
+  void ForEachBottomToTop(Func func) {
+    for (auto* child = bottom_child_; child; child = child->above_) {
+      func(child);
+      child->ForEachBottomToTop(func);
+    }
+  }
+
+  // Calls |func| with each descendant from the top to the bottom.
+  template <typename Func>
+  void ForEachTopToBottom(Func func) {
+    for (auto* child = top_child_; child; child = child->below_) {
+      child->ForEachTopToBottom(func);
+      func(child);
+    }
+  }
+
+ private:
+  Type type_;
+  WaylandBindingHandler* handler_;
+  SceneNode* parent_ = nullptr;
+  SceneNode* above_ = nullptr;
+  SceneNode* below_ = nullptr;
+  SceneNode* bottom_child_ = nullptr;
+  SceneNode* top_child_ = nullptr;
+  Vec2<int> position_;
+  Rect<int> output_rect_;
+  Vec2<int> surface_size_;
+  bool visible_ = false;
+  uint32_t unchanged_frames_ = 0;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_COMPOSITOR_SCENE_NODE_H_
@@ -2,12 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include <chrono>
-#include <cmath>
 #include <iostream>
 #include <memory>
 #include <string>
-#include <thread>
 
 #include "waffle/compositor/compositor.h"
 #include "waffle/wayland_server.h"
@@ -20,41 +17,23 @@ int main(int argc, char** argv) {
       .view_rotation = waffle::WaffleViewRotation::kRotation_0,
       .use_mouse_cursor = true,
       .background_image_filepath = "../assets/system-bg.png",
+      .repaint_deadline_ms = 7,
+      .hidden_frame_callback_interval_ms = 1000,
   };
   auto server = std::make_unique<waffle::WaylandServer>();
   waffle::Compositor::Create(server->Display(), properties);
   auto* compositor = waffle::Compositor::Instance();
 
-  // Main loop.
-  auto next_waffle_event_time =
-      std::chrono::steady_clock::time_point::clock::now();
+  // Main loop. It sleeps until a client request, a backend event or the
+  // repaint timer arrives.
   auto running = true;
   while (running) {
-    // Wait until the next event.
-    {
-      auto wait_duration =
-          std::max(std::chrono::nanoseconds(0),
-                   next_waffle_event_time -
-                       std::chrono::steady_clock::time_point::clock::now());
-      std::this_thread::sleep_for(
-          std::chrono::duration_cast<std::chrono::milliseconds>(wait_duration));
-    }
-
-    server->HandleEvent();
-    compositor->Draw();
     running = compositor->HandleEvent();
-
-    {
-      auto next_event_time = std::chrono::steady_clock::time_point::max();
-      auto frame_rate = compositor->GetFrameRate();
-      next_event_time = std::min(
-          next_event_time, std::chrono::steady_clock::time_point::clock::now() +
-                               std::chrono::milliseconds(static_cast<int>(
-                                   std::trunc(1000000.0 / frame_rate))));
-      next_waffle_event_time =
-          std::max(next_waffle_event_time, next_event_time);
-    }
+    server->HandleEvent();
   }
+  // Destroy the server first. Windows and surfaces notify the compositor when
+  // they are destroyed.
+  server = nullptr;
   compositor->Destroy();
 
   return 0;
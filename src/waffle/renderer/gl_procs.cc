@@ -0,0 +1,94 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/renderer/gl_procs.h"
+
+#include <type_traits>
+
+#include "waffle/logger.h"
+
+namespace waffle {
+
+const struct GlProcs& GlProcs() {
+  static struct GlProcs procs = {};
+  static bool initialized = false;
+  if (!initialized) {
+    procs.valid = true;
+    auto load = [](auto& proc, const char* name) {
+      proc = reinterpret_cast<std::remove_reference_t<decltype(proc)>>(
+          eglGetProcAddress(name));
+      if (!proc) {
+        WAFFLE_LOG(ERROR) << "Failed to load " << name;
+        procs.valid = false;
+      }
+    };
+    load(procs.glGenTextures, "glGenTextures");
+    load(procs.glDeleteTextures, "glDeleteTextures");
+    load(procs.glBindTexture, "glBindTexture");
+    load(procs.glActiveTexture, "glActiveTexture");
+    load(procs.glTexParameteri, "glTexParameteri");
+    load(procs.glTexImage2D, "glTexImage2D");
+    load(procs.glTexSubImage2D, "glTexSubImage2D");
+    load(procs.glPixelStorei, "glPixelStorei");
+    load(procs.glCreateShader, "glCreateShader");
+    load(procs.glShaderSource, "glShaderSource");
+    load(procs.glCompileShader, "glCompileShader");
+    load(procs.glGetShaderiv, "glGetShaderiv");
+    load(procs.glGetShaderInfoLog, "glGetShaderInfoLog");
+    load(procs.glDeleteShader, "glDeleteShader");
+    load(procs.glCreateProgram, "glCreateProgram");
+    load(procs.glAttachShader, "glAttachShader");
+    load(procs.glLinkProgram, "glLinkProgram");
+    load(procs.glGetProgramiv, "glGetProgramiv");
+    load(procs.glGetProgramInfoLog, "glGetProgramInfoLog");
+    load(procs.glDeleteProgram, "glDeleteProgram");
+    load(procs.glUseProgram, "glUseProgram");
+    load(procs.glGetActiveUniform, "glGetActiveUniform");
+    load(procs.glGetUniformLocation, "glGetUniformLocation");
+    load(procs.glUniform1i, "glUniform1i");
+    load(procs.glUniform3fv, "glUniform3fv");
+    load(procs.glUniformMatrix3fv, "glUniformMatrix3fv");
+    load(procs.glUniformMatrix4fv, "glUniformMatrix4fv");
+    load(procs.glGenBuffers, "glGenBuffers");
+    load(procs.glDeleteBuffers, "glDeleteBuffers");
+    load(procs.glBindBuffer, "glBindBuffer");
+    load(procs.glBufferData, "glBufferData");
+    load(procs.glMapBufferRange, "glMapBufferRange");
+    load(procs.glUnmapBuffer, "glUnmapBuffer");
+    load(procs.glGenVertexArrays, "glGenVertexArrays");
+    load(procs.glDeleteVertexArrays, "glDeleteVertexArrays");
+    load(procs.glBindVertexArray, "glBindVertexArray");
+    load(procs.glVertexAttribPointer, "glVertexAttribPointer");
+    load(procs.glEnableVertexAttribArray, "glEnableVertexAttribArray");
+    load(procs.glGenFramebuffers, "glGenFramebuffers");
+    load(procs.glDeleteFramebuffers, "glDeleteFramebuffers");
+    load(procs.glBindFramebuffer, "glBindFramebuffer");
+    load(procs.glFramebufferTexture2D, "glFramebufferTexture2D");
+    load(procs.glCheckFramebufferStatus, "glCheckFramebufferStatus");
+    load(procs.glFenceSync, "glFenceSync");
+    load(procs.glClientWaitSync, "glClientWaitSync");
+    load(procs.glDeleteSync, "glDeleteSync");
+    load(procs.glGetString, "glGetString");
+    load(procs.glViewport, "glViewport");
+    load(procs.glEnable, "glEnable");
+    load(procs.glDisable, "glDisable");
+    load(procs.glBlendFunc, "glBlendFunc");
+    load(procs.glDrawElements, "glDrawElements");
+    load(procs.glDrawArrays, "glDrawArrays");
+
+    procs.glEGLImageTargetTexture2DOES =
+        reinterpret_cast<glEGLImageTargetTexture2DOESProc>(
+            eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+    procs.glBufferStorageEXT = reinterpret_cast<PFNGLBUFFERSTORAGEEXTPROC>(
+        eglGetProcAddress("glBufferStorageEXT"));
+
+    if (!procs.valid) {
+      WAFFLE_LOG(ERROR) << "Failed to load GlProcs";
+    }
+    initialized = true;
+  }
+  return procs;
+}
+
+}  // namespace waffle
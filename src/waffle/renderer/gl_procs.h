@@ -0,0 +1,99 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_RENDERER_GL_PROCS_H_
+#define WAFFLE_RENDERER_GL_PROCS_H_
+
+#include <EGL/egl.h>
+#include <GLES3/gl32.h>
+// gl2ext.h needs the types of gl32.h.
+#include <GLES2/gl2ext.h>
+
+namespace waffle {
+
+typedef void (*glEGLImageTargetTexture2DOESProc)(GLenum target, EGLImage image);
+
+// The GL functions used by the compositor. They are resolved only once and
+// shared by all modules.
+struct GlProcs {
+  // Textures.
+  PFNGLGENTEXTURESPROC glGenTextures;
+  PFNGLDELETETEXTURESPROC glDeleteTextures;
+  PFNGLBINDTEXTUREPROC glBindTexture;
+  PFNGLACTIVETEXTUREPROC glActiveTexture;
+  PFNGLTEXPARAMETERIPROC glTexParameteri;
+  PFNGLTEXIMAGE2DPROC glTexImage2D;
+  PFNGLTEXSUBIMAGE2DPROC glTexSubImage2D;
+  PFNGLPIXELSTOREIPROC glPixelStorei;
+
+  // Shaders and programs.
+  PFNGLCREATESHADERPROC glCreateShader;
+  PFNGLSHADERSOURCEPROC glShaderSource;
+  PFNGLCOMPILESHADERPROC glCompileShader;
+  PFNGLGETSHADERIVPROC glGetShaderiv;
+  PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog;
+  PFNGLDELETESHADERPROC glDeleteShader;
+  PFNGLCREATEPROGRAMPROC glCreateProgram;
+  PFNGLATTACHSHADERPROC glAttachShader;
+  PFNGLLINKPROGRAMPROC glLinkProgram;
+  PFNGLGETPROGRAMIVPROC glGetProgramiv;
+  PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog;
+  PFNGLDELETEPROGRAMPROC glDeleteProgram;
+  PFNGLUSEPROGRAMPROC glUseProgram;
+  PFNGLGETACTIVEUNIFORMPROC glGetActiveUniform;
+  PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
+  PFNGLUNIFORM1IPROC glUniform1i;
+  PFNGLUNIFORM3FVPROC glUniform3fv;
+  PFNGLUNIFORMMATRIX3FVPROC glUniformMatrix3fv;
+  PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv;
+
+  // Buffers and vertex arrays.
+  PFNGLGENBUFFERSPROC glGenBuffers;
+  PFNGLDELETEBUFFERSPROC glDeleteBuffers;
+  PFNGLBINDBUFFERPROC glBindBuffer;
+  PFNGLBUFFERDATAPROC glBufferData;
+  PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+  PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+  PFNGLGENVERTEXARRAYSPROC glGenVertexArrays;
+  PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays;
+  PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
+  PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer;
+  PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
+
+  // Framebuffers.
+  PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers;
+  PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers;
+  PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer;
+  PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D;
+  PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus;
+
+  // Synchronization.
+  PFNGLFENCESYNCPROC glFenceSync;
+  PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+  PFNGLDELETESYNCPROC glDeleteSync;
+
+  // Rendering.
+  PFNGLGETSTRINGPROC glGetString;
+  PFNGLVIEWPORTPROC glViewport;
+  PFNGLENABLEPROC glEnable;
+  PFNGLDISABLEPROC glDisable;
+  PFNGLBLENDFUNCPROC glBlendFunc;
+  PFNGLDRAWELEMENTSPROC glDrawElements;
+  PFNGLDRAWARRAYSPROC glDrawArrays;
+
+  // Optional extensions. These are nullptr if they are not supported.
+  // GL_OES_EGL_image.
+  glEGLImageTargetTexture2DOESProc glEGLImageTargetTexture2DOES;
+  // GL_EXT_buffer_storage.
+  PFNGLBUFFERSTORAGEEXTPROC glBufferStorageEXT;
+
+  // Whether all the functions except the optional ones are available.
+  bool valid;
+};
+
+const struct GlProcs& GlProcs();
+
+}  // namespace waffle
+
+#endif  // WAFFLE_RENDERER_GL_PROCS_H_
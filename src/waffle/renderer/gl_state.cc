@@ -0,0 +1,140 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/renderer/gl_state.h"
+
+#include "waffle/renderer/gl_procs.h"
+
+namespace waffle {
+
+GlState& GlState::Instance() {
+  static GlState state;
+  return state;
+}
+
+void GlState::Invalidate() {
+  program_ = kUnknown;
+  active_texture_ = kUnknown;
+  texture_units_.fill(TextureUnit());
+  vertex_array_ = kUnknown;
+  framebuffer_ = kUnknown;
+  blend_ = Toggle::kUnknown;
+  blend_sfactor_ = kUnknown;
+  blend_dfactor_ = kUnknown;
+}
+
+void GlState::UseProgram(GLuint program) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || program_ == program) {
+    return;
+  }
+  gl.glUseProgram(program);
+  program_ = program;
+}
+
+void GlState::ActiveTexture(GLuint unit) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || active_texture_ == unit) {
+    return;
+  }
+  gl.glActiveTexture(GL_TEXTURE0 + unit);
+  active_texture_ = unit;
+}
+
+void GlState::BindTexture(GLuint texture, GLenum target) {
+  const auto& gl = GlProcs();
+  auto& binding = TextureBinding(target);
+  if (!gl.valid || binding == texture) {
+    return;
+  }
+  gl.glBindTexture(target, texture);
+  binding = texture;
+}
+
+void GlState::BindVertexArray(GLuint vertex_array) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || vertex_array_ == vertex_array) {
+    return;
+  }
+  gl.glBindVertexArray(vertex_array);
+  vertex_array_ = vertex_array;
+}
+
+void GlState::BindFramebuffer(GLuint framebuffer) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || framebuffer_ == framebuffer) {
+    return;
+  }
+  gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  framebuffer_ = framebuffer;
+}
+
+void GlState::SetBlend(bool enabled) {
+  const auto& gl = GlProcs();
+  auto blend = enabled ? Toggle::kEnabled : Toggle::kDisabled;
+  if (!gl.valid || blend_ == blend) {
+    return;
+  }
+  if (enabled) {
+    gl.glEnable(GL_BLEND);
+  } else {
+    gl.glDisable(GL_BLEND);
+  }
+  blend_ = blend;
+}
+
+void GlState::BlendFunc(GLenum sfactor, GLenum dfactor) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || (blend_sfactor_ == sfactor && blend_dfactor_ == dfactor)) {
+    return;
+  }
+  gl.glBlendFunc(sfactor, dfactor);
+  blend_sfactor_ = sfactor;
+  blend_dfactor_ = dfactor;
+}
+
+void GlState::OnProgramDeleted(GLuint program) {
+  // A program in use is kept until another one is used, but its name is
+  // freed then.
+  if (program_ == program) {
+    program_ = kUnknown;
+  }
+}
+
+void GlState::OnTextureDeleted(GLuint texture) {
+  // Deleting a bound texture reverts the binding to 0.
+  for (auto& unit : texture_units_) {
+    if (unit.texture_2d == texture) {
+      unit.texture_2d = 0;
+    }
+    if (unit.texture_external == texture) {
+      unit.texture_external = 0;
+    }
+  }
+}
+
+void GlState::OnVertexArrayDeleted(GLuint vertex_array) {
+  // Deleting a bound vertex array reverts the binding to 0.
+  if (vertex_array_ == vertex_array) {
+    vertex_array_ = 0;
+  }
+}
+
+void GlState::OnFramebufferDeleted(GLuint framebuffer) {
+  // Deleting a bound framebuffer reverts the binding to 0.
+  if (framebuffer_ == framebuffer) {
+    framebuffer_ = 0;
+  }
+}
+
+GLuint& GlState::TextureBinding(GLenum target) {
+  // The unit is unknown only before the first ActiveTexture(), and GL starts
+  // with the unit 0 then.
+  auto& unit =
+      texture_units_[active_texture_ == kUnknown ? 0 : active_texture_];
+  return target == GL_TEXTURE_EXTERNAL_OES ? unit.texture_external
+                                           : unit.texture_2d;
+}
+
+}  // namespace waffle
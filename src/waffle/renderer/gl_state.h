@@ -0,0 +1,93 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_RENDERER_GL_STATE_H_
+#define WAFFLE_RENDERER_GL_STATE_H_
+
+#include <GLES3/gl32.h>
+
+#include <array>
+
+namespace waffle {
+
+// Cache of the GL state which is changed for every window. The GL calls are
+// skipped when the state is already set, so all changes of the cached state
+// must go through this class. Invalidate() must be called when the state may
+// have been changed behind it, e.g. when the on-screen surface is recreated.
+class GlState {
+ public:
+  static GlState& Instance();
+
+  ~GlState() = default;
+
+  // Prevent copying.
+  GlState(GlState const&) = delete;
+  GlState& operator=(GlState const&) = delete;
+
+  // Forgets the cached state. The next changes are always sent to GL.
+  void Invalidate();
+
+  void UseProgram(GLuint program);
+
+  // Selects the texture unit GL_TEXTURE0 + |unit| which BindTexture() binds
+  // to. |unit| must be less than kMaxTextureUnits.
+  void ActiveTexture(GLuint unit);
+
+  // Binds |texture| to |target| of the active texture unit. |target| is
+  // GL_TEXTURE_2D or GL_TEXTURE_EXTERNAL_OES.
+  void BindTexture(GLuint texture, GLenum target = GL_TEXTURE_2D);
+
+  void BindVertexArray(GLuint vertex_array);
+
+  // Binds |framebuffer| to GL_FRAMEBUFFER. 0 is the output.
+  void BindFramebuffer(GLuint framebuffer);
+
+  void SetBlend(bool enabled);
+
+  void BlendFunc(GLenum sfactor, GLenum dfactor);
+
+  // These must be called when the objects are deleted, because GL may reuse
+  // their names.
+  void OnProgramDeleted(GLuint program);
+  void OnTextureDeleted(GLuint texture);
+  void OnVertexArrayDeleted(GLuint vertex_array);
+  void OnFramebufferDeleted(GLuint framebuffer);
+
+  // The number of the texture units whose bindings are cached. This covers
+  // all the planes of a texture.
+  static constexpr GLuint kMaxTextureUnits = 3;
+
+ private:
+  // Never equal to any GL name, so the state is set for the first time.
+  static constexpr GLuint kUnknown = ~0u;
+
+  struct TextureUnit {
+    GLuint texture_2d = kUnknown;
+    GLuint texture_external = kUnknown;
+  };
+
+  enum class Toggle {
+    kUnknown,
+    kEnabled,
+    kDisabled,
+  };
+
+  GlState() = default;
+
+  // Returns the cached binding of |target| of the active texture unit.
+  GLuint& TextureBinding(GLenum target);
+
+  GLuint program_ = kUnknown;
+  GLuint active_texture_ = kUnknown;
+  std::array<TextureUnit, kMaxTextureUnits> texture_units_;
+  GLuint vertex_array_ = kUnknown;
+  GLuint framebuffer_ = kUnknown;
+  Toggle blend_ = Toggle::kUnknown;
+  GLenum blend_sfactor_ = kUnknown;
+  GLenum blend_dfactor_ = kUnknown;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_RENDERER_GL_STATE_H_
@@ -0,0 +1,248 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/renderer/quad_batch.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "waffle/logger.h"
+#include "waffle/renderer/gl_procs.h"
+#include "waffle/renderer/gl_state.h"
+
+namespace waffle {
+
+namespace {
+
+constexpr char kVertexShaderCode[] =
+    "#version 300 es                                         \n"
+    "layout (location = 0) in vec2 position;                 \n"
+    "layout (location = 1) in vec2 texturePositionIn;        \n"
+    "layout (location = 2) in float opacityIn;               \n"
+    "out vec2 texturePosition;                               \n"
+    "out float opacity;                                      \n"
+    "void main() {                                           \n"
+    "  gl_Position = vec4(position, 0.0f, 1.0f);             \n"
+    "  texturePosition = texturePositionIn;                  \n"
+    "  opacity = opacityIn;                                  \n"
+    "}                                                       \n";
+
+// Quads are drawn as two triangles without an index buffer.
+constexpr GLsizei kVerticesPerQuad = 6;
+
+ShaderVariant VariantOf(TextureFormat format) {
+  switch (format) {
+    case TextureFormat::kARGB8888:
+      return ShaderVariant::kBGRA;
+    case TextureFormat::kXRGB8888:
+      return ShaderVariant::kBGRX;
+    case TextureFormat::kStraightRGBA8888:
+      return ShaderVariant::kStraightRGBA;
+    case TextureFormat::kExternal:
+      return ShaderVariant::kExternalOES;
+    case TextureFormat::kNV12:
+      return ShaderVariant::kNV12;
+    case TextureFormat::kI420:
+      return ShaderVariant::kI420;
+    case TextureFormat::kYUYV:
+      return ShaderVariant::kYUYV;
+    default:
+      return ShaderVariant::kRGBA;
+  }
+}
+
+// Converts (Y, U, V) - offset to RGB by the column-major matrix.
+struct YuvConversion {
+  GLfloat matrix[9];
+  GLfloat offset[3];
+};
+
+// Indexed by YuvColorSpace.
+constexpr YuvConversion kYuvConversions[] = {
+    // BT.601 limited range.
+    {{1.164f, 1.164f, 1.164f, 0.0f, -0.392f, 2.017f, 1.596f, -0.813f, 0.0f},
+     {16.0f / 255, 128.0f / 255, 128.0f / 255}},
+    // BT.601 full range.
+    {{1.0f, 1.0f, 1.0f, 0.0f, -0.344f, 1.772f, 1.402f, -0.714f, 0.0f},
+     {0.0f, 128.0f / 255, 128.0f / 255}},
+    // BT.709 limited range.
+    {{1.164f, 1.164f, 1.164f, 0.0f, -0.213f, 2.112f, 1.793f, -0.533f, 0.0f},
+     {16.0f / 255, 128.0f / 255, 128.0f / 255}},
+    // BT.709 full range.
+    {{1.0f, 1.0f, 1.0f, 0.0f, -0.187f, 1.856f, 1.575f, -0.468f, 0.0f},
+     {0.0f, 128.0f / 255, 128.0f / 255}},
+};
+
+bool HasExtension(const char* name) {
+  const auto& gl = GlProcs();
+  auto* extensions =
+      reinterpret_cast<const char*>(gl.glGetString(GL_EXTENSIONS));
+  return extensions && strstr(extensions, name);
+}
+
+}  // namespace
+
+QuadBatch::~QuadBatch() {
+  const auto& gl = GlProcs();
+  if (!gl.valid || !vertex_array_) {
+    return;
+  }
+  gl.glDeleteVertexArrays(1, &vertex_array_);
+  GlState::Instance().OnVertexArrayDeleted(vertex_array_);
+}
+
+bool QuadBatch::Init() {
+  const auto& gl = GlProcs();
+  if (!gl.valid) {
+    return false;
+  }
+
+  auto external_supported = HasExtension("GL_OES_EGL_image_external_essl3");
+  for (size_t i = 0; i < kShaderVariantCount; i++) {
+    auto variant = static_cast<ShaderVariant>(i);
+    if (variant == ShaderVariant::kExternalOES && !external_supported) {
+      WAFFLE_LOG(INFO) << "External textures aren't supported";
+      continue;
+    }
+    auto& program = programs_[i];
+    program.shader = std::make_unique<Shader>();
+    program.shader->LoadProgram(kVertexShaderCode,
+                                FragmentShaderCode(variant));
+    if (IsYuvVariant(variant)) {
+      // The planes are sampled from the texture units in order.
+      program.shader->Bind();
+      for (int plane = 1; plane < VariantPlaneCount(variant); plane++) {
+        program.shader->UniformInt(
+            program.shader->UniformLocation(PlaneSamplerName(plane)), plane);
+      }
+      program.yuv_to_rgb = program.shader->UniformLocation("yuvToRgb");
+      program.yuv_offset = program.shader->UniformLocation("yuvOffset");
+    }
+  }
+  vertex_ring_ = std::make_unique<UploadBufferRing>(GL_ARRAY_BUFFER);
+
+  gl.glGenVertexArrays(1, &vertex_array_);
+  auto& state = GlState::Instance();
+  state.BindVertexArray(vertex_array_);
+  gl.glEnableVertexAttribArray(0);
+  gl.glEnableVertexAttribArray(1);
+  gl.glEnableVertexAttribArray(2);
+  state.BindVertexArray(0);
+  return true;
+}
+
+void QuadBatch::SetColorSpace(Program& program, YuvColorSpace color_space) {
+  if (program.color_space == color_space) {
+    return;
+  }
+  const auto& conversion = kYuvConversions[static_cast<size_t>(color_space)];
+  program.shader->UniformMatrix3(program.yuv_to_rgb, conversion.matrix);
+  program.shader->UniformVec3(program.yuv_offset, conversion.offset);
+  program.color_space = color_space;
+}
+
+void QuadBatch::Begin(Vec2<int> output_size, bool flip_y) {
+  output_size_ = output_size;
+  flip_y_ = flip_y;
+  vertices_.clear();
+  runs_.clear();
+}
+
+void QuadBatch::Add(Texture& texture,
+                    const Rect<double>& dest,
+                    const Rect<double>& source,
+                    bool blend,
+                    float opacity) {
+  if (dest.IsEmpty() || output_size_.X() <= 0 || output_size_.Y() <= 0) {
+    return;
+  }
+
+  // To the normalized device coordinates whose origin is the center and y
+  // goes up.
+  auto to_x = [this](double x) {
+    return static_cast<GLfloat>(x * 2 / output_size_.X() - 1);
+  };
+  auto to_y = [this](double y) {
+    auto ndc_y = 1 - y * 2 / output_size_.Y();
+    return static_cast<GLfloat>(flip_y_ ? -ndc_y : ndc_y);
+  };
+  auto left = to_x(dest.X());
+  auto right = to_x(dest.Right());
+  auto top = to_y(dest.Y());
+  auto bottom = to_y(dest.Bottom());
+  auto u0 = static_cast<GLfloat>(source.X());
+  auto u1 = static_cast<GLfloat>(source.Right());
+  auto v0 = static_cast<GLfloat>(source.Y());
+  auto v1 = static_cast<GLfloat>(source.Bottom());
+
+  auto variant = VariantOf(texture.Format());
+  blend = blend && !IsOpaqueVariant(variant);
+
+  auto first = static_cast<GLint>(vertices_.size());
+  vertices_.push_back({left, top, u0, v0, opacity});
+  vertices_.push_back({left, bottom, u0, v1, opacity});
+  vertices_.push_back({right, top, u1, v0, opacity});
+  vertices_.push_back({right, top, u1, v0, opacity});
+  vertices_.push_back({left, bottom, u0, v1, opacity});
+  vertices_.push_back({right, bottom, u1, v1, opacity});
+
+  if (!runs_.empty()) {
+    auto& run = runs_.back();
+    if (run.blend == blend && run.texture.Id() == texture.Id()) {
+      run.count += kVerticesPerQuad;
+      return;
+    }
+  }
+  runs_.push_back({texture, variant, blend, first, kVerticesPerQuad});
+}
+
+void QuadBatch::Flush() {
+  const auto& gl = GlProcs();
+  if (!gl.valid || !vertex_ring_ || runs_.empty()) {
+    return;
+  }
+
+  auto size = vertices_.size() * sizeof(Vertex);
+  auto* data = vertex_ring_->Map(size);
+  if (!data) {
+    return;
+  }
+  memcpy(data, vertices_.data(), size);
+  vertex_ring_->Unmap();
+
+  // The buffer of the ring may change every frame, so the attributes are
+  // pointed at it again while it's bound.
+  auto& state = GlState::Instance();
+  state.BindVertexArray(vertex_array_);
+  constexpr GLsizei kStride = sizeof(Vertex);
+  gl.glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, kStride,
+                           reinterpret_cast<GLvoid*>(offsetof(Vertex, x)));
+  gl.glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, kStride,
+                           reinterpret_cast<GLvoid*>(offsetof(Vertex, u)));
+  gl.glVertexAttribPointer(
+      2, 1, GL_FLOAT, GL_FALSE, kStride,
+      reinterpret_cast<GLvoid*>(offsetof(Vertex, opacity)));
+
+  state.BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  for (auto& run : runs_) {
+    auto& program = programs_[static_cast<size_t>(run.variant)];
+    if (!program.shader) {
+      continue;
+    }
+    program.shader->Bind();
+    if (IsYuvVariant(run.variant)) {
+      SetColorSpace(program, run.texture.ColorSpace());
+    }
+    run.texture.Bind();
+    state.SetBlend(run.blend);
+    gl.glDrawArrays(GL_TRIANGLES, run.first, run.count);
+  }
+
+  // The buffer is reused after the GPU has read the vertices.
+  vertex_ring_->Submit();
+  runs_.clear();
+  vertices_.clear();
+}
+
+}  // namespace waffle
@@ -0,0 +1,102 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_RENDERER_QUAD_BATCH_H_
+#define WAFFLE_RENDERER_QUAD_BATCH_H_
+
+#include <GLES3/gl32.h>
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "waffle/renderer/shader/shader.h"
+#include "waffle/renderer/shader/shader_variant.h"
+#include "waffle/renderer/texture.h"
+#include "waffle/renderer/upload_buffer_ring.h"
+#include "waffle/utils/rect.h"
+#include "waffle/utils/vec2.h"
+
+namespace waffle {
+
+// Draws the textured quads of a frame with as few draw calls as possible.
+//
+// The vertices of all quads are written into one vertex stream per frame,
+// which is a persistently mapped buffer when it's supported. Each texture is
+// drawn by the shader variant of its format. Consecutive quads which use the
+// same texture and blending are drawn by one call, so the quads should be
+// added grouped by them.
+class QuadBatch {
+ public:
+  QuadBatch() = default;
+  ~QuadBatch();
+
+  // Prevent copying.
+  QuadBatch(QuadBatch const&) = delete;
+  QuadBatch& operator=(QuadBatch const&) = delete;
+
+  // The GL context must be current.
+  bool Init();
+
+  // Starts a new frame drawn on the output of |output_size|. If |flip_y| is
+  // true, it's drawn upside down. This is for render targets which are
+  // sampled as textures later, so that their first row is the top like
+  // client buffers.
+  void Begin(Vec2<int> output_size, bool flip_y = false);
+
+  // Adds a quad which shows |source| of |texture| in |dest|. |dest| is in
+  // output pixels and |source| is in normalized texture coordinates. Both
+  // have their origins at the top-left corner. |blend| is ignored if the
+  // format of |texture| is always opaque.
+  void Add(Texture& texture,
+           const Rect<double>& dest,
+           const Rect<double>& source,
+           bool blend,
+           float opacity = 1.0f);
+
+  // Draws all the quads in the order they were added.
+  void Flush();
+
+ private:
+  struct Vertex {
+    GLfloat x, y;
+    GLfloat u, v;
+    GLfloat opacity;
+  };
+
+  // Quads which are drawn by one call.
+  struct Run {
+    Texture texture;
+    ShaderVariant variant;
+    bool blend;
+    GLint first;
+    GLsizei count;
+  };
+
+  struct Program {
+    // nullptr if GL doesn't support the variant.
+    std::unique_ptr<Shader> shader;
+    // The uniforms of the YUV variants.
+    GLint yuv_to_rgb = -1;
+    GLint yuv_offset = -1;
+    std::optional<YuvColorSpace> color_space;
+  };
+
+  // Sets the colour conversion of a YUV |program|, which must be bound.
+  void SetColorSpace(Program& program, YuvColorSpace color_space);
+
+  // Indexed by ShaderVariant.
+  std::array<Program, kShaderVariantCount> programs_;
+  std::unique_ptr<UploadBufferRing> vertex_ring_;
+  GLuint vertex_array_ = 0;
+  Vec2<int> output_size_;
+  bool flip_y_ = false;
+  std::vector<Vertex> vertices_;
+  std::vector<Run> runs_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_RENDERER_QUAD_BATCH_H_
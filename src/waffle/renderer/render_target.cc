@@ -0,0 +1,76 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/renderer/render_target.h"
+
+#include <utility>
+
+#include "waffle/logger.h"
+#include "waffle/renderer/gl_procs.h"
+#include "waffle/renderer/gl_state.h"
+
+namespace waffle {
+
+RenderTarget::RenderTarget(Vec2<int> size) : size_(size) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || size.X() <= 0 || size.Y() <= 0) {
+    return;
+  }
+
+  texture_.Allocate(size.X(), size.Y());
+
+  gl.glGenFramebuffers(1, &framebuffer_);
+  auto& state = GlState::Instance();
+  state.BindFramebuffer(framebuffer_);
+  gl.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_TEXTURE_2D, texture_.Id(), 0);
+  auto status = gl.glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  state.BindFramebuffer(0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    WAFFLE_LOG(ERROR) << "Failed to create a render target: " << status;
+    return;
+  }
+  valid_ = true;
+}
+
+RenderTarget::~RenderTarget() {
+  const auto& gl = GlProcs();
+  if (!gl.valid || !framebuffer_) {
+    return;
+  }
+  gl.glDeleteFramebuffers(1, &framebuffer_);
+  GlState::Instance().OnFramebufferDeleted(framebuffer_);
+}
+
+void RenderTarget::Bind() {
+  GlState::Instance().BindFramebuffer(framebuffer_);
+}
+
+void RenderTarget::Unbind() {
+  GlState::Instance().BindFramebuffer(0);
+}
+
+std::unique_ptr<RenderTarget> RenderTargetPool::Acquire(Vec2<int> size) {
+  for (auto itr = targets_.begin(); itr != targets_.end(); ++itr) {
+    auto target_size = (*itr)->Size();
+    if (target_size.X() == size.X() && target_size.Y() == size.Y()) {
+      auto target = std::move(*itr);
+      targets_.erase(itr);
+      return target;
+    }
+  }
+  return std::make_unique<RenderTarget>(size);
+}
+
+void RenderTargetPool::Release(std::unique_ptr<RenderTarget> target) {
+  if (!target || !target->IsValid()) {
+    return;
+  }
+  targets_.push_back(std::move(target));
+  if (targets_.size() > kMaxPooledTargets) {
+    targets_.erase(targets_.begin());
+  }
+}
+
+}  // namespace waffle
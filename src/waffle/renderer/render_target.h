@@ -0,0 +1,78 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_RENDERER_RENDER_TARGET_H_
+#define WAFFLE_RENDERER_RENDER_TARGET_H_
+
+#include <GLES3/gl32.h>
+
+#include <memory>
+#include <vector>
+
+#include "waffle/renderer/texture.h"
+#include "waffle/utils/vec2.h"
+
+namespace waffle {
+
+// An offscreen framebuffer whose colour buffer is a texture, so that what is
+// drawn into it can be drawn again as a texture.
+class RenderTarget {
+ public:
+  // Allocates a target of |size|. The GL context must be current.
+  explicit RenderTarget(Vec2<int> size);
+  ~RenderTarget();
+
+  // Prevent copying.
+  RenderTarget(RenderTarget const&) = delete;
+  RenderTarget& operator=(RenderTarget const&) = delete;
+
+  bool IsValid() const { return valid_; }
+
+  Vec2<int> Size() const { return size_; }
+
+  // The colour buffer. It has premultiplied alpha.
+  Texture& GetTexture() { return texture_; }
+
+  // Directs the following draws into this target. The viewport isn't changed,
+  // so it must be set for the size of the target.
+  void Bind();
+
+  // Directs the following draws to the default framebuffer, i.e. the output.
+  static void Unbind();
+
+ private:
+  Texture texture_;
+  GLuint framebuffer_ = 0;
+  Vec2<int> size_;
+  bool valid_ = false;
+};
+
+// Keeps released render targets to reuse them instead of allocating
+// framebuffers and textures again.
+class RenderTargetPool {
+ public:
+  RenderTargetPool() = default;
+  ~RenderTargetPool() = default;
+
+  // Prevent copying.
+  RenderTargetPool(RenderTargetPool const&) = delete;
+  RenderTargetPool& operator=(RenderTargetPool const&) = delete;
+
+  // Returns a target of |size|. A released one is reused if it has the same
+  // size. Otherwise, a new one is allocated.
+  std::unique_ptr<RenderTarget> Acquire(Vec2<int> size);
+
+  // Returns |target| to the pool. The oldest targets are freed when the pool
+  // is full.
+  void Release(std::unique_ptr<RenderTarget> target);
+
+ private:
+  static constexpr size_t kMaxPooledTargets = 2;
+
+  std::vector<std::unique_ptr<RenderTarget>> targets_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_RENDERER_RENDER_TARGET_H_
@@ -11,33 +11,11 @@
 #include <string>
 
 #include "waffle/logger.h"
+#include "waffle/renderer/gl_procs.h"
+#include "waffle/renderer/gl_state.h"
 
 namespace waffle {
 
-namespace {
-
-struct GlProcs {
-  PFNGLUSEPROGRAMPROC glUseProgram;
-  bool valid;
-};
-
-static const GlProcs& GlProcs() {
-  static struct GlProcs procs = {};
-  static bool initialized = false;
-  if (!initialized) {
-    procs.glUseProgram = reinterpret_cast<PFNGLUSEPROGRAMPROC>(
-        eglGetProcAddress("glUseProgram"));
-    procs.valid = procs.glUseProgram;
-    if (!procs.valid) {
-      WAFFLE_LOG(ERROR) << "Failed to load GlProcs";
-    }
-    initialized = true;
-  }
-  return procs;
-}
-
-}  // namespace
-
 void Shader::LoadProgram(std::string vertex_code, std::string fragment_code) {
   auto vertex = std::make_unique<ShaderContext>(vertex_code, GL_VERTEX_SHADER);
   auto fragment =
@@ -47,28 +25,51 @@ void Shader::LoadProgram(std::string vertex_code, std::string fragment_code) {
 }
 
 void Shader::Bind() {
+  GlState::Instance().UseProgram(program_->Program());
+}
+
+void Shader::Unbind() {
+  GlState::Instance().UseProgram(0);
+}
+
+GLint Shader::UniformLocation(const std::string& name) const {
+  auto location = program_->UniformLocation(name);
+  if (location == -1) {
+    WAFFLE_LOG(ERROR) << "Failed to get uniform location (" << name << ")";
+  }
+  return location;
+}
+
+void Shader::UniformMatrix(GLint location, GLfloat* data) {
   const auto& gl = GlProcs();
-  if (!gl.valid) {
+  if (!gl.valid || location == -1) {
     return;
   }
-  gl.glUseProgram(program_->Program());
+  gl.glUniformMatrix4fv(location, 1, GL_FALSE, data);
 }
 
-void Shader::Unbind() {
+void Shader::UniformInt(GLint location, GLint value) {
   const auto& gl = GlProcs();
-  if (!gl.valid) {
+  if (!gl.valid || location == -1) {
     return;
   }
-  gl.glUseProgram(false);
+  gl.glUniform1i(location, value);
 }
 
-void Shader::UniformMatrix(std::string name, GLfloat* data) {
-  auto location = glGetUniformLocation(program_->Program(), name.c_str());
-  if (location == -1) {
-    WAFFLE_LOG(ERROR) << "Failed to get uniform location (" << name << ")";
+void Shader::UniformMatrix3(GLint location, const GLfloat* data) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || location == -1) {
+    return;
+  }
+  gl.glUniformMatrix3fv(location, 1, GL_FALSE, data);
+}
+
+void Shader::UniformVec3(GLint location, const GLfloat* data) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || location == -1) {
     return;
   }
-  glUniformMatrix4fv(location, 1, GL_FALSE, data);
+  gl.glUniform3fv(location, 1, data);
 }
 
 }  // namespace waffle
@@ -25,7 +25,20 @@ class Shader {
   void Bind();
   void Unbind();
   GLuint Program() const { return program_->Program(); }
-  void UniformMatrix(std::string name, GLfloat* data);
+
+  // Returns the location of the uniform |name|, or -1 if it doesn't exist.
+  // This should be called once after loading the program, not per draw.
+  GLint UniformLocation(const std::string& name) const;
+
+  void UniformMatrix(GLint location, GLfloat* data);
+
+  // Sets an int uniform, e.g. the texture unit of a sampler. The program must
+  // be bound.
+  void UniformInt(GLint location, GLint value);
+
+  void UniformMatrix3(GLint location, const GLfloat* data);
+
+  void UniformVec3(GLint location, const GLfloat* data);
 
  private:
   std::unique_ptr<ShaderProgram> program_;
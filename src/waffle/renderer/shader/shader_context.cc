@@ -11,50 +11,10 @@
 #include <string>
 
 #include "waffle/logger.h"
+#include "waffle/renderer/gl_procs.h"
 
 namespace waffle {
 
-namespace {
-
-struct GlProcs {
-  PFNGLCREATESHADERPROC glCreateShader;
-  PFNGLSHADERSOURCEPROC glShaderSource;
-  PFNGLCOMPILESHADERPROC glCompileShader;
-  PFNGLGETSHADERIVPROC glGetShaderiv;
-  PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog;
-  PFNGLDELETESHADERPROC glDeleteShader;
-  bool valid;
-};
-
-static const GlProcs& GlProcs() {
-  static struct GlProcs procs = {};
-  static bool initialized = false;
-  if (!initialized) {
-    procs.glCreateShader = reinterpret_cast<PFNGLCREATESHADERPROC>(
-        eglGetProcAddress("glCreateShader"));
-    procs.glShaderSource = reinterpret_cast<PFNGLSHADERSOURCEPROC>(
-        eglGetProcAddress("glShaderSource"));
-    procs.glCompileShader = reinterpret_cast<PFNGLCOMPILESHADERPROC>(
-        eglGetProcAddress("glCompileShader"));
-    procs.glGetShaderiv = reinterpret_cast<PFNGLGETSHADERIVPROC>(
-        eglGetProcAddress("glGetShaderiv"));
-    procs.glGetShaderInfoLog = reinterpret_cast<PFNGLGETSHADERINFOLOGPROC>(
-        eglGetProcAddress("glGetShaderInfoLog"));
-    procs.glDeleteShader = reinterpret_cast<PFNGLDELETESHADERPROC>(
-        eglGetProcAddress("glDeleteShader"));
-    procs.valid = procs.glCreateShader && procs.glShaderSource &&
-                  procs.glCompileShader && procs.glGetShaderiv &&
-                  procs.glGetShaderInfoLog && procs.glDeleteShader;
-    if (!procs.valid) {
-      WAFFLE_LOG(ERROR) << "Failed to load GlProcs";
-    }
-    initialized = true;
-  }
-  return procs;
-}
-
-}  // namespace
-
 ShaderContext::ShaderContext(std::string code, GLenum type) : shader_(0) {
   const auto& gl = GlProcs();
   if (!gl.valid) {
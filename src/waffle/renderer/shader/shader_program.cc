@@ -11,50 +11,11 @@
 #include <string>
 
 #include "waffle/logger.h"
+#include "waffle/renderer/gl_procs.h"
+#include "waffle/renderer/gl_state.h"
 
 namespace waffle {
 
-namespace {
-
-struct GlProcs {
-  PFNGLCREATEPROGRAMPROC glCreateProgram;
-  PFNGLATTACHSHADERPROC glAttachShader;
-  PFNGLLINKPROGRAMPROC glLinkProgram;
-  PFNGLGETPROGRAMIVPROC glGetProgramiv;
-  PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog;
-  PFNGLDELETEPROGRAMPROC glDeleteProgram;
-  bool valid;
-};
-
-static const GlProcs& GlProcs() {
-  static struct GlProcs procs = {};
-  static bool initialized = false;
-  if (!initialized) {
-    procs.glCreateProgram = reinterpret_cast<PFNGLCREATEPROGRAMPROC>(
-        eglGetProcAddress("glCreateProgram"));
-    procs.glAttachShader = reinterpret_cast<PFNGLATTACHSHADERPROC>(
-        eglGetProcAddress("glAttachShader"));
-    procs.glLinkProgram = reinterpret_cast<PFNGLLINKPROGRAMPROC>(
-        eglGetProcAddress("glLinkProgram"));
-    procs.glGetProgramiv = reinterpret_cast<PFNGLGETPROGRAMIVPROC>(
-        eglGetProcAddress("glGetProgramiv"));
-    procs.glGetProgramInfoLog = reinterpret_cast<PFNGLGETPROGRAMINFOLOGPROC>(
-        eglGetProcAddress("glGetProgramInfoLog"));
-    procs.glDeleteProgram = reinterpret_cast<PFNGLDELETEPROGRAMPROC>(
-        eglGetProcAddress("glDeleteProgram"));
-    procs.valid = procs.glCreateProgram && procs.glAttachShader &&
-                  procs.glLinkProgram && procs.glGetProgramiv &&
-                  procs.glGetProgramInfoLog && procs.glDeleteProgram;
-    if (!procs.valid) {
-      WAFFLE_LOG(ERROR) << "Failed to load GlProcs";
-    }
-    initialized = true;
-  }
-  return procs;
-}
-
-}  // namespace
-
 ShaderProgram::ShaderProgram(std::unique_ptr<ShaderContext> vertex_shader,
                              std::unique_ptr<ShaderContext> fragment_shader)
     : vertex_shader_(std::move(vertex_shader)),
@@ -85,6 +46,18 @@ ShaderProgram::ShaderProgram(std::unique_ptr<ShaderContext> vertex_shader,
 
     gl.glDeleteProgram(program_);
     program_ = 0;
+    return;
+  }
+
+  GLint count = 0;
+  gl.glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &count);
+  for (GLint i = 0; i < count; i++) {
+    GLchar name[256];
+    GLint size;
+    GLenum type;
+    gl.glGetActiveUniform(program_, i, sizeof(name), nullptr, &size, &type,
+                          name);
+    uniform_locations_[name] = gl.glGetUniformLocation(program_, name);
   }
 }
 
@@ -94,6 +67,15 @@ ShaderProgram::~ShaderProgram() {
     return;
   }
   gl.glDeleteProgram(program_);
+  GlState::Instance().OnProgramDeleted(program_);
+}
+
+GLint ShaderProgram::UniformLocation(const std::string& name) const {
+  auto itr = uniform_locations_.find(name);
+  if (itr == uniform_locations_.end()) {
+    return -1;
+  }
+  return itr->second;
 }
 
 }  // namespace waffle
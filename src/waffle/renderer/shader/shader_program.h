@@ -9,6 +9,8 @@
 #include <GLES3/gl32.h>
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #include "waffle/renderer/shader/shader_context.h"
 
@@ -22,8 +24,13 @@ class ShaderProgram {
 
   GLuint Program() const { return program_; }
 
+  // Returns the location of the uniform |name|, or -1 if the program doesn't
+  // have it. The locations are looked up when the program is linked.
+  GLint UniformLocation(const std::string& name) const;
+
  private:
   GLuint program_;
+  std::unordered_map<std::string, GLint> uniform_locations_;
   std::unique_ptr<ShaderContext> vertex_shader_;
   std::unique_ptr<ShaderContext> fragment_shader_;
 };
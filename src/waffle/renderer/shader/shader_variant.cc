@@ -0,0 +1,124 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/renderer/shader/shader_variant.h"
+
+namespace waffle {
+
+namespace {
+
+struct VariantInfo {
+  ShaderVariant variant;
+  // Prepended to kFragmentShaderTemplate.
+  const char* defines;
+  bool opaque;
+  // The number of the texture planes. Variants with multiple planes are YUV.
+  int planes;
+};
+
+// Indexed by ShaderVariant.
+constexpr VariantInfo kVariants[] = {
+    {ShaderVariant::kRGBA, "", false, 1},
+    {ShaderVariant::kStraightRGBA, "#define STRAIGHT_ALPHA\n", false, 1},
+    {ShaderVariant::kBGRA, "#define SWIZZLE_BGRA\n", false, 1},
+    {ShaderVariant::kBGRX, "#define SWIZZLE_BGRA\n#define OPAQUE\n", true, 1},
+    {ShaderVariant::kExternalOES, "#define EXTERNAL_OES\n", false, 1},
+    {ShaderVariant::kNV12, "#define YUV\n#define NV12\n", true, 2},
+    {ShaderVariant::kI420, "#define YUV\n#define I420\n", true, 3},
+    {ShaderVariant::kYUYV, "#define YUV\n#define YUYV\n", true, 2},
+};
+
+static_assert(sizeof(kVariants) / sizeof(kVariants[0]) == kShaderVariantCount,
+              "All shader variants must be in kVariants");
+
+constexpr bool IsIndexedByVariant() {
+  for (size_t i = 0; i < kShaderVariantCount; i++) {
+    if (static_cast<size_t>(kVariants[i].variant) != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(IsIndexedByVariant(), "kVariants must be indexed by variant");
+
+constexpr char kFragmentShaderTemplate[] =
+    "#ifdef EXTERNAL_OES                                     \n"
+    "#extension GL_OES_EGL_image_external_essl3 : require    \n"
+    "#endif                                                  \n"
+    "precision mediump float;                                \n"
+    "in vec2 texturePosition;                                \n"
+    "in float opacity;                                       \n"
+    "out vec4 color;                                         \n"
+    "#ifdef EXTERNAL_OES                                     \n"
+    "uniform samplerExternalOES textureData;                 \n"
+    "#else                                                   \n"
+    "uniform sampler2D textureData;                          \n"
+    "#endif                                                  \n"
+    "#ifdef YUV                                              \n"
+    "uniform sampler2D textureData1;                         \n"
+    "#ifdef I420                                             \n"
+    "uniform sampler2D textureData2;                         \n"
+    "#endif                                                  \n"
+    "uniform mat3 yuvToRgb;                                  \n"
+    "uniform vec3 yuvOffset;                                 \n"
+    "#endif                                                  \n"
+    "vec4 Sample() {                                         \n"
+    "#ifdef YUV                                              \n"
+    "  vec3 yuv;                                             \n"
+    "  yuv.x = texture(textureData, texturePosition).r;      \n"
+    "#if defined(NV12)                                       \n"
+    "  yuv.yz = texture(textureData1, texturePosition).rg;   \n"
+    "#elif defined(I420)                                     \n"
+    "  yuv.y = texture(textureData1, texturePosition).r;     \n"
+    "  yuv.z = texture(textureData2, texturePosition).r;     \n"
+    "#elif defined(YUYV)                                     \n"
+    "  yuv.yz = texture(textureData1, texturePosition).ga;   \n"
+    "#endif                                                  \n"
+    "  return vec4(yuvToRgb * (yuv - yuvOffset), 1.0);       \n"
+    "#else                                                   \n"
+    "  vec4 texel = texture(textureData, texturePosition);   \n"
+    "#ifdef SWIZZLE_BGRA                                     \n"
+    "  texel = texel.bgra;                                   \n"
+    "#endif                                                  \n"
+    "#ifdef OPAQUE                                           \n"
+    "  texel.a = 1.0;                                        \n"
+    "#endif                                                  \n"
+    "#ifdef STRAIGHT_ALPHA                                   \n"
+    "  texel.rgb *= texel.a;                                 \n"
+    "#endif                                                  \n"
+    "  return texel;                                         \n"
+    "#endif                                                  \n"
+    "}                                                       \n"
+    "void main() {                                           \n"
+    "  color = Sample() * opacity;                           \n"
+    "}                                                       \n";
+
+}  // namespace
+
+std::string FragmentShaderCode(ShaderVariant variant) {
+  // #version must be the first line, so the defines follow it.
+  std::string code = "#version 300 es\n";
+  code += kVariants[static_cast<size_t>(variant)].defines;
+  code += kFragmentShaderTemplate;
+  return code;
+}
+
+bool IsOpaqueVariant(ShaderVariant variant) {
+  return kVariants[static_cast<size_t>(variant)].opaque;
+}
+
+int VariantPlaneCount(ShaderVariant variant) {
+  return kVariants[static_cast<size_t>(variant)].planes;
+}
+
+bool IsYuvVariant(ShaderVariant variant) {
+  return VariantPlaneCount(variant) > 1;
+}
+
+std::string PlaneSamplerName(int plane) {
+  return plane == 0 ? "textureData" : "textureData" + std::to_string(plane);
+}
+
+}  // namespace waffle
@@ -0,0 +1,63 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_RENDERER_SHADER_SHADER_VARIANT_H_
+#define WAFFLE_RENDERER_SHADER_SHADER_VARIANT_H_
+
+#include <cstddef>
+#include <string>
+
+namespace waffle {
+
+// Variants of the fragment shader which samples a texture. All of them are
+// generated from one template, so each buffer format is converted in the
+// shader instead of by texture state set on upload. They all output
+// premultiplied alpha.
+enum class ShaderVariant {
+  // RGBA with premultiplied alpha, e.g. EGL buffers and dmabufs.
+  kRGBA,
+  // RGBA with straight alpha, e.g. image files.
+  kStraightRGBA,
+  // BGRA in memory uploaded as RGBA, i.e. wl_shm ARGB8888.
+  kBGRA,
+  // BGRX in memory uploaded as RGBA, i.e. wl_shm XRGB8888. The alpha is
+  // forced to 1.
+  kBGRX,
+  // EGLImages which can only be sampled as GL_TEXTURE_EXTERNAL_OES.
+  kExternalOES,
+  // The YUV variants below sample the planes bound to the texture units in
+  // order, and convert them by the yuvToRgb and yuvOffset uniforms.
+  //
+  // Y plane and interleaved UV plane.
+  kNV12,
+  // Y, U and V planes.
+  kI420,
+  // RG view of packed YUYV for Y and RGBA view of it for U and V.
+  kYUYV,
+  kCount,
+};
+
+constexpr size_t kShaderVariantCount =
+    static_cast<size_t>(ShaderVariant::kCount);
+
+// Returns the source of the fragment shader of |variant|. The shader takes
+// the texture coordinates in |texturePosition| and the opacity in |opacity|.
+std::string FragmentShaderCode(ShaderVariant variant);
+
+// Returns true if |variant| always outputs opaque pixels, so the quads drawn
+// by it don't need blending.
+bool IsOpaqueVariant(ShaderVariant variant);
+
+// Returns the number of the texture planes which |variant| samples.
+int VariantPlaneCount(ShaderVariant variant);
+
+// Returns true if |variant| converts YUV planes to RGB.
+bool IsYuvVariant(ShaderVariant variant);
+
+// Returns the name of the sampler uniform of |plane|.
+std::string PlaneSamplerName(int plane);
+
+}  // namespace waffle
+
+#endif  // WAFFLE_RENDERER_SHADER_SHADER_VARIANT_H_
@@ -8,43 +8,73 @@
 #include <GLES3/gl32.h>
 #include <SOIL/SOIL.h>
 
+#include <cstring>
+#include <utility>
+#include <vector>
+
 #include "waffle/logger.h"
+#include "waffle/renderer/gl_procs.h"
+#include "waffle/renderer/gl_state.h"
+#include "waffle/renderer/upload_buffer_ring.h"
 
 namespace waffle {
 
 namespace {
 
-typedef void (*glEGLImageTargetTexture2DOESProc)(GLenum target, EGLImage image);
+// Where a plane is in a client buffer and how it's uploaded.
+struct PlaneLayout {
+  // Of the first row of the plane in the buffer.
+  size_t offset;
+  int stride;
+  int bytes_per_pixel;
+  // The plane has 1 / subsampling of the pixels of the buffer.
+  int horizontal_subsampling;
+  int vertical_subsampling;
+  GLint internal_format;
+  GLenum format;
 
-struct GlProcs {
-  glEGLImageTargetTexture2DOESProc glEGLImageTargetTexture2DOES;
-  PFNGLBINDTEXTUREPROC glBindTexture;
-  PFNGLTEXPARAMETERIPROC glTexParameteri;
-  PFNGLTEXIMAGE2DPROC glTexImage2D;
-  bool valid;
+  // Converts |rect| in the buffer to the pixels of the plane which cover it.
+  Rect<int> ToPlaneRect(const Rect<int>& rect) const {
+    auto left = rect.X() / horizontal_subsampling;
+    auto top = rect.Y() / vertical_subsampling;
+    auto right = (rect.Right() + horizontal_subsampling - 1) /
+                 horizontal_subsampling;
+    auto bottom =
+        (rect.Bottom() + vertical_subsampling - 1) / vertical_subsampling;
+    return Rect<int>(left, top, right - left, bottom - top);
+  }
 };
 
-static const GlProcs& GlProcs() {
-  static struct GlProcs procs = {};
-  static bool initialized = false;
-  if (!initialized) {
-    procs.glEGLImageTargetTexture2DOES =
-        reinterpret_cast<glEGLImageTargetTexture2DOESProc>(
-            eglGetProcAddress("glEGLImageTargetTexture2DOES"));
-    procs.glBindTexture = reinterpret_cast<PFNGLBINDTEXTUREPROC>(
-        eglGetProcAddress("glBindTexture"));
-    procs.glTexParameteri = reinterpret_cast<PFNGLTEXPARAMETERIPROC>(
-        eglGetProcAddress("glTexParameteri"));
-    procs.glTexImage2D = reinterpret_cast<PFNGLTEXIMAGE2DPROC>(
-        eglGetProcAddress("glTexImage2D"));
-    procs.valid = procs.glEGLImageTargetTexture2DOES && procs.glBindTexture &&
-                  procs.glTexParameteri && procs.glTexImage2D;
-    if (!procs.valid) {
-      WAFFLE_LOG(ERROR) << "Failed to load GlProcs";
+// Returns the planes of a client buffer of |format|. The planes of YUV
+// formats follow each other in the same buffer as DRM lays them out.
+std::vector<PlaneLayout> PlaneLayouts(TextureFormat format,
+                                      int height,
+                                      int stride) {
+  switch (format) {
+    case TextureFormat::kNV12: {
+      // The UV plane has the same stride as the Y plane.
+      auto uv_offset = static_cast<size_t>(stride) * height;
+      return {{0, stride, 1, 1, 1, GL_R8, GL_RED},
+              {uv_offset, stride, 2, 2, 2, GL_RG8, GL_RG}};
     }
-    initialized = true;
+    case TextureFormat::kI420: {
+      // The U and V planes have half the stride of the Y plane.
+      auto chroma_stride = stride / 2;
+      auto u_offset = static_cast<size_t>(stride) * height;
+      auto v_offset =
+          u_offset + static_cast<size_t>(chroma_stride) * ((height + 1) / 2);
+      return {{0, stride, 1, 1, 1, GL_R8, GL_RED},
+              {u_offset, chroma_stride, 1, 2, 2, GL_R8, GL_RED},
+              {v_offset, chroma_stride, 1, 2, 2, GL_R8, GL_RED}};
+    }
+    case TextureFormat::kYUYV:
+      // Two views of the same pixels. Y0 and Y1 are the R of the first one,
+      // and U and V are the G and A of the second one.
+      return {{0, stride, 2, 1, 1, GL_RG8, GL_RG},
+              {0, stride, 4, 2, 1, GL_RGBA8, GL_RGBA}};
+    default:
+      return {{0, stride, 4, 1, 1, GL_RGBA, GL_RGBA}};
   }
-  return procs;
 }
 
 }  // namespace
@@ -53,6 +83,13 @@ Texture::Texture() {
   Init();
 }
 
+Texture::Texture(std::shared_ptr<TextureContext> context)
+    : context_(std::move(context)) {}
+
+Texture Texture::Empty() {
+  return Texture(nullptr);
+}
+
 void Texture::Init() {
   if (!context_) {
     context_ = std::make_shared<TextureContext>();
@@ -76,7 +113,7 @@ void Texture::LoadFileImage(std::string filename) {
   if (!gl.valid) {
     return;
   }
-  gl.glBindTexture(GL_TEXTURE_2D, context_->Texture());
+  GlState::Instance().BindTexture(context_->Texture());
   {
     gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -85,73 +122,218 @@ void Texture::LoadFileImage(std::string filename) {
     gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
                     GL_UNSIGNED_BYTE, image);
   }
-  gl.glBindTexture(GL_TEXTURE_2D, 0);
 
   context_->Size(width, height);
+  context_->Format(TextureFormat::kStraightRGBA8888);
   SOIL_free_image_data(image);
 }
 
-void Texture::LoadEGLImage(void* image, int x, int y) {
-  if (!context_) {
-    context_ = std::make_shared<TextureContext>();
+void Texture::LoadEGLImage(void* image, int x, int y, bool external) {
+  GLenum target = external ? GL_TEXTURE_EXTERNAL_OES : GL_TEXTURE_2D;
+  if (!context_ || context_->Target() != target) {
+    context_ = std::make_shared<TextureContext>(target);
   }
 
   const auto& gl = GlProcs();
-  if (!gl.valid) {
+  if (!gl.valid || !gl.glEGLImageTargetTexture2DOES) {
     return;
   }
-  gl.glBindTexture(GL_TEXTURE_2D, context_->Texture());
-  gl.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, image);
-  gl.glBindTexture(GL_TEXTURE_2D, 0);
+  GlState::Instance().BindTexture(context_->Texture(), target);
+  gl.glEGLImageTargetTexture2DOES(target, image);
 
   context_->Size(x, y);
+  context_->Format(external ? TextureFormat::kExternal
+                            : TextureFormat::kRGBA8888);
 }
 
-void Texture::LoadBufferImage(void* data, int x, int y) {
-  if (!context_) {
-    context_ = std::make_shared<TextureContext>();
+void Texture::LoadEGLImagePlanes(const std::vector<void*>& images,
+                                 int x,
+                                 int y,
+                                 TextureFormat format) {
+  auto num_planes = static_cast<int>(images.size());
+  if (!context_ || context_->Target() != GL_TEXTURE_2D ||
+      context_->NumPlanes() != num_planes) {
+    context_ = std::make_shared<TextureContext>(GL_TEXTURE_2D, num_planes);
   }
 
   const auto& gl = GlProcs();
-  if (!gl.valid) {
+  if (!gl.valid || !gl.glEGLImageTargetTexture2DOES) {
     return;
   }
-  gl.glBindTexture(GL_TEXTURE_2D, context_->Texture());
-  {
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    // todo:
-    // SHM color format(ARGB8888) to RGBA format.
-    // SHM's ARGB8888 means BGRA.
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_BLUE);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_GREEN);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_ALPHA);
-    gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA,
-                    GL_UNSIGNED_BYTE, data);
+  for (int plane = 0; plane < num_planes; plane++) {
+    GlState::Instance().BindTexture(context_->Texture(plane));
+    gl.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, images[plane]);
   }
-  gl.glBindTexture(GL_TEXTURE_2D, 0);
 
   context_->Size(x, y);
+  context_->Format(format);
+  context_->ColorSpace(DefaultYuvColorSpace(y));
 }
 
-void Texture::Bind() {
+void Texture::LoadBufferImage(void* data,
+                              int width,
+                              int height,
+                              int stride,
+                              TextureFormat format,
+                              const Region& damage) {
+  auto planes = PlaneLayouts(format, height, stride);
+  auto num_planes = static_cast<int>(planes.size());
+  if (!context_ || context_->NumPlanes() != num_planes) {
+    context_ = std::make_shared<TextureContext>(GL_TEXTURE_2D, num_planes);
+  }
+
   const auto& gl = GlProcs();
   if (!gl.valid) {
     return;
   }
-  gl.glBindTexture(GL_TEXTURE_2D, context_->Texture());
+
+  auto size = context_->Size();
+  auto reallocate = size.X() != width || size.Y() != height ||
+                    context_->Format() != format;
+
+  std::vector<Rect<int>> rects;
+  auto bounds = Rect<int>(0, 0, width, height);
+  if (reallocate) {
+    rects.push_back(bounds);
+  } else {
+    for (const auto& damaged : damage.Rects()) {
+      auto rect = damaged.Intersect(bounds);
+      if (!rect.IsEmpty()) {
+        rects.push_back(rect);
+      }
+    }
+    if (rects.empty()) {
+      return;
+    }
+  }
+
+  // The damaged rectangles in the coordinates of each plane.
+  std::vector<std::vector<Rect<int>>> plane_rects(num_planes);
+  size_t upload_size = 0;
+  for (int plane = 0; plane < num_planes; plane++) {
+    const auto& layout = planes[plane];
+    for (const auto& rect : rects) {
+      auto plane_rect = layout.ToPlaneRect(rect);
+      upload_size += static_cast<size_t>(plane_rect.Width()) *
+                     plane_rect.Height() * layout.bytes_per_pixel;
+      plane_rects[plane].push_back(plane_rect);
+    }
+  }
+
+  // Copy the damaged pixels into an upload buffer so that the client buffer
+  // can be released as soon as this returns and GL copies them to the
+  // texture asynchronously.
+  auto& ring = UploadBufferRing::Instance();
+  auto* staging = ring.Map(upload_size);
+  std::vector<std::vector<const uint8_t*>> sources(num_planes);
+  size_t offset = 0;
+  for (int plane = 0; plane < num_planes; plane++) {
+    const auto& layout = planes[plane];
+    for (const auto& rect : plane_rects[plane]) {
+      auto* src = static_cast<const uint8_t*>(data) + layout.offset +
+                  static_cast<size_t>(rect.Y()) * layout.stride +
+                  static_cast<size_t>(rect.X()) * layout.bytes_per_pixel;
+      if (!staging) {
+        // Fall back to uploading from the client buffer directly.
+        sources[plane].push_back(src);
+        continue;
+      }
+      size_t row_size =
+          static_cast<size_t>(rect.Width()) * layout.bytes_per_pixel;
+      // The offset in the bound GL_PIXEL_UNPACK_BUFFER.
+      sources[plane].push_back(reinterpret_cast<const uint8_t*>(offset));
+      for (int row = 0; row < rect.Height(); row++) {
+        memcpy(staging + offset, src, row_size);
+        offset += row_size;
+        src += layout.stride;
+      }
+    }
+  }
+  if (staging) {
+    ring.Unmap();
+  }
+
+  // Rows of the planes which are narrower than 4 bytes per pixel may not be
+  // 4-byte aligned.
+  if (num_planes > 1) {
+    gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  }
+  for (int plane = 0; plane < num_planes; plane++) {
+    const auto& layout = planes[plane];
+    if (!staging) {
+      // The rows of the client buffer may be padded, so let GL skip the
+      // padding.
+      gl.glPixelStorei(GL_UNPACK_ROW_LENGTH,
+                       layout.stride / layout.bytes_per_pixel);
+    }
+
+    GlState::Instance().BindTexture(context_->Texture(plane));
+    if (reallocate) {
+      // The pixels are uploaded in the memory order of the buffer, and
+      // converted by the shader variant of |format|, e.g. ARGB8888 (BGRA in
+      // memory) is swizzled.
+      auto plane_size = layout.ToPlaneRect(bounds);
+      gl.glTexImage2D(GL_TEXTURE_2D, 0, layout.internal_format,
+                      plane_size.Width(), plane_size.Height(), 0,
+                      layout.format, GL_UNSIGNED_BYTE, sources[plane][0]);
+    } else {
+      for (size_t i = 0; i < plane_rects[plane].size(); i++) {
+        const auto& rect = plane_rects[plane][i];
+        gl.glTexSubImage2D(GL_TEXTURE_2D, 0, rect.X(), rect.Y(), rect.Width(),
+                           rect.Height(), layout.format, GL_UNSIGNED_BYTE,
+                           sources[plane][i]);
+      }
+    }
+  }
+  if (num_planes > 1) {
+    gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  }
+
+  if (reallocate) {
+    context_->Size(width, height);
+    context_->Format(format);
+    context_->ColorSpace(DefaultYuvColorSpace(height));
+  }
+
+  if (staging) {
+    ring.Submit();
+  } else {
+    gl.glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  }
 }
 
-void Texture::Unbind() {
+void Texture::Allocate(int width, int height) {
+  if (!context_ || context_->Target() != GL_TEXTURE_2D ||
+      context_->NumPlanes() != 1) {
+    context_ = std::make_shared<TextureContext>();
+  }
+
   const auto& gl = GlProcs();
   if (!gl.valid) {
     return;
   }
-  gl.glBindTexture(GL_TEXTURE_2D, 0);
+  GlState::Instance().BindTexture(context_->Texture());
+  gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                  GL_UNSIGNED_BYTE, nullptr);
+
+  context_->Size(width, height);
+  context_->Format(TextureFormat::kRGBA8888);
+}
+
+void Texture::Bind() {
+  auto& state = GlState::Instance();
+  for (int plane = context_->NumPlanes() - 1; plane >= 0; plane--) {
+    state.ActiveTexture(plane);
+    state.BindTexture(context_->Texture(plane), context_->Target());
+  }
+}
+
+void Texture::Unbind() {
+  auto& state = GlState::Instance();
+  for (int plane = context_->NumPlanes() - 1; plane >= 0; plane--) {
+    state.ActiveTexture(plane);
+    state.BindTexture(0, context_->Target());
+  }
 }
 
 Vec2<int> Texture::Size() {
@@ -7,8 +7,10 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "waffle/renderer/texture_context.h"
+#include "waffle/utils/region.h"
 #include "waffle/utils/vec2.h"
 
 namespace waffle {
@@ -18,16 +20,65 @@ class Texture {
   Texture();
   ~Texture() = default;
 
+  // Returns a texture without a GL texture. Valid() is false until Init() is
+  // called. e.g. to receive a cached texture by assignment without
+  // allocating one only to be replaced.
+  static Texture Empty();
+
   void Init();
   bool Valid() const { return context_ != nullptr; };
+  // Returns the name of the GL texture, or 0 if it's not initialized.
+  GLuint Id() const { return context_ ? context_->Texture() : 0; }
   Vec2<int> Size();
-  void LoadEGLImage(void* image, int x, int y);
-  void LoadBufferImage(void* image, int x, int y);
+  TextureFormat Format() const {
+    return context_ ? context_->Format() : TextureFormat::kUnknown;
+  }
+  GLenum Target() const {
+    return context_ ? context_->Target() : GL_TEXTURE_2D;
+  }
+  YuvColorSpace ColorSpace() const {
+    return context_ ? context_->ColorSpace() : YuvColorSpace::kBT601Limited;
+  }
+
+  // Binds an EGLImage with premultiplied alpha. If |external| is true, the
+  // image is bound to GL_TEXTURE_EXTERNAL_OES, e.g. because it's in a YUV
+  // format or has a modifier which GL_TEXTURE_2D doesn't support.
+  void LoadEGLImage(void* image, int x, int y, bool external = false);
+
+  // Binds an EGLImage to each plane of a YUV |format|, e.g. R8 and GR88
+  // images of the planes of an NV12 dmabuf. |x| and |y| are the size of the
+  // first plane.
+  void LoadEGLImagePlanes(const std::vector<void*>& images,
+                          int x,
+                          int y,
+                          TextureFormat format);
+
+  // Uploads the pixels of a client buffer. The texture storage is allocated
+  // only when the size or the format of the buffer changed. Otherwise, only
+  // |damage| in the buffer coordinates is uploaded. |stride| is the length of
+  // a row in bytes. The pixels are copied before this returns and GL uploads
+  // them asynchronously, so the client buffer can be released right away.
+  // The planes of YUV formats are uploaded to their own textures.
+  void LoadBufferImage(void* data,
+                       int width,
+                       int height,
+                       int stride,
+                       TextureFormat format,
+                       const Region& damage);
   void LoadFileImage(std::string filename);
+
+  // Allocates RGBA storage of |width| x |height| without any contents, e.g.
+  // for rendering into it. It has premultiplied alpha.
+  void Allocate(int width, int height);
+
+  // Binds the planes to the texture units in order. The unit 0 is left
+  // active.
   void Bind();
   void Unbind();
 
  private:
+  explicit Texture(std::shared_ptr<TextureContext> context);
+
   std::shared_ptr<TextureContext> context_ = nullptr;
 };
 
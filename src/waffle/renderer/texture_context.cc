@@ -7,58 +7,44 @@
 #include <EGL/egl.h>
 
 #include "waffle/logger.h"
+#include "waffle/renderer/gl_procs.h"
+#include "waffle/renderer/gl_state.h"
 
 namespace waffle {
 
-namespace {
-
-struct GlProcs {
-  PFNGLGENTEXTURESPROC glGenTextures;
-  PFNGLDELETETEXTURESPROC glDeleteTextures;
-  PFNGLBINDTEXTUREPROC glBindTexture;
-  PFNGLTEXPARAMETERIPROC glTexParameteri;
-  bool valid;
-};
-
-static const GlProcs& GlProcs() {
-  static struct GlProcs procs = {};
-  static bool initialized = false;
-  if (!initialized) {
-    procs.glGenTextures = reinterpret_cast<PFNGLGENTEXTURESPROC>(
-        eglGetProcAddress("glGenTextures"));
-    procs.glDeleteTextures = reinterpret_cast<PFNGLDELETETEXTURESPROC>(
-        eglGetProcAddress("glDeleteTextures"));
-    procs.glBindTexture = reinterpret_cast<PFNGLBINDTEXTUREPROC>(
-        eglGetProcAddress("glBindTexture"));
-    procs.glTexParameteri = reinterpret_cast<PFNGLTEXPARAMETERIPROC>(
-        eglGetProcAddress("glTexParameteri"));
-    procs.valid = procs.glGenTextures && procs.glDeleteTextures &&
-                  procs.glBindTexture && procs.glTexParameteri;
-    if (!procs.valid) {
-      WAFFLE_LOG(ERROR) << "Failed to load GlProcs";
-    }
-    initialized = true;
+int TexturePlaneCount(TextureFormat format) {
+  switch (format) {
+    case TextureFormat::kNV12:
+    case TextureFormat::kYUYV:
+      return 2;
+    case TextureFormat::kI420:
+      return 3;
+    default:
+      return 1;
   }
-  return procs;
 }
 
-}  // namespace
+YuvColorSpace DefaultYuvColorSpace(int height) {
+  constexpr int kHdHeight = 720;
+  return height >= kHdHeight ? YuvColorSpace::kBT709Limited
+                             : YuvColorSpace::kBT601Limited;
+}
 
-TextureContext::TextureContext() {
+TextureContext::TextureContext(GLenum target, int num_planes)
+    : texture_ids_(num_planes, 0), target_(target) {
   const auto& gl = GlProcs();
   if (!gl.valid) {
     return;
   }
 
-  gl.glGenTextures(1, &texture_id_);
-  gl.glBindTexture(GL_TEXTURE_2D, texture_id_);
-  {
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  gl.glGenTextures(num_planes, texture_ids_.data());
+  for (auto texture_id : texture_ids_) {
+    GlState::Instance().BindTexture(texture_id, target_);
+    gl.glTexParameteri(target_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl.glTexParameteri(target_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl.glTexParameteri(target_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl.glTexParameteri(target_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   }
-  gl.glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 TextureContext::~TextureContext() {
@@ -67,7 +53,10 @@ TextureContext::~TextureContext() {
     return;
   }
 
-  gl.glDeleteTextures(1, &texture_id_);
+  gl.glDeleteTextures(NumPlanes(), texture_ids_.data());
+  for (auto texture_id : texture_ids_) {
+    GlState::Instance().OnTextureDeleted(texture_id);
+  }
 }
 
 }  // namespace waffle
@@ -7,22 +7,77 @@
 
 #include <GLES3/gl32.h>
 
+#include <vector>
+
 #include "waffle/utils/vec2.h"
 
 namespace waffle {
 
+// Pixel formats of the texture sources.
+enum class TextureFormat {
+  kUnknown,
+  // 32-bit BGRA in memory, i.e. wl_shm ARGB8888.
+  kARGB8888,
+  // 32-bit BGRX in memory, i.e. wl_shm XRGB8888.
+  kXRGB8888,
+  // RGBA with premultiplied alpha, i.e. EGLImages of client buffers.
+  kRGBA8888,
+  // RGBA with straight alpha, i.e. image files.
+  kStraightRGBA8888,
+  // EGLImages which can only be sampled as GL_TEXTURE_EXTERNAL_OES.
+  kExternal,
+  // 8-bit Y plane and 2x2 subsampled interleaved UV plane.
+  kNV12,
+  // 8-bit Y, U and V planes. U and V are 2x2 subsampled.
+  kI420,
+  // Packed Y0 U Y1 V. It's sampled through two views of the same pixels,
+  // an RG plane for Y and a half-width RGBA plane for U and V.
+  kYUYV,
+};
+
+// The maximum number of the planes of a texture.
+constexpr int kTextureMaxPlanes = 3;
+
+// Returns the number of the planes which |format| is sampled from.
+int TexturePlaneCount(TextureFormat format);
+
+// Colour spaces of YUV textures. Neither wl_shm nor linux-dmabuf tells
+// them, so they are guessed from the buffer size.
+enum class YuvColorSpace {
+  kBT601Limited,
+  kBT601Full,
+  kBT709Limited,
+  kBT709Full,
+};
+
+// Returns the colour space which video of |height| lines is most likely in,
+// i.e. BT.709 for HD and BT.601 for SD, both with the limited range.
+YuvColorSpace DefaultYuvColorSpace(int height);
+
 class TextureContext {
  public:
-  TextureContext();
+  // |target| is GL_TEXTURE_2D or GL_TEXTURE_EXTERNAL_OES. The texture can't
+  // be bound to the other target later. A GL texture is created for each of
+  // |num_planes|.
+  explicit TextureContext(GLenum target = GL_TEXTURE_2D, int num_planes = 1);
   ~TextureContext();
 
   void Size(int x, int y) { texture_size_ = Vec2<int>(x, y); }
   Vec2<int> Size() { return texture_size_; }
-  GLuint Texture() { return texture_id_; }
+  void Format(TextureFormat format) { format_ = format; }
+  TextureFormat Format() { return format_; }
+  void ColorSpace(YuvColorSpace color_space) { color_space_ = color_space; }
+  YuvColorSpace ColorSpace() { return color_space_; }
+  GLuint Texture(int plane = 0) { return texture_ids_[plane]; }
+  int NumPlanes() { return static_cast<int>(texture_ids_.size()); }
+  GLenum Target() { return target_; }
 
  private:
-  GLuint texture_id_ = 0;
+  std::vector<GLuint> texture_ids_;
+  GLenum target_;
   Vec2<int> texture_size_;
+  TextureFormat format_ = TextureFormat::kUnknown;
+  YuvColorSpace color_space_ = YuvColorSpace::kBT601Limited;
 };
 
 }  // namespace waffle
@@ -0,0 +1,173 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/renderer/upload_buffer_ring.h"
+
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+
+#include <cstring>
+
+#include "waffle/logger.h"
+#include "waffle/renderer/gl_procs.h"
+
+namespace waffle {
+
+namespace {
+
+// The buffers grow in steps of this size to avoid reallocating them for every
+// slightly larger upload.
+constexpr size_t kCapacityAlignment = 1024 * 1024;
+
+}  // namespace
+
+UploadBufferRing& UploadBufferRing::Instance() {
+  static UploadBufferRing ring(GL_PIXEL_UNPACK_BUFFER);
+  return ring;
+}
+
+UploadBufferRing::UploadBufferRing(GLenum target) : target_(target) {
+  const auto& gl = GlProcs();
+  if (!gl.valid) {
+    return;
+  }
+
+  auto* extensions =
+      reinterpret_cast<const char*>(gl.glGetString(GL_EXTENSIONS));
+  persistent_ = gl.glBufferStorageEXT && extensions &&
+                strstr(extensions, "GL_EXT_buffer_storage");
+  WAFFLE_LOG(TRACE) << "Persistently mapped upload buffers: "
+                    << (persistent_ ? "yes" : "no");
+}
+
+UploadBufferRing::~UploadBufferRing() {
+  const auto& gl = GlProcs();
+  if (!gl.valid) {
+    return;
+  }
+
+  for (auto& slot : slots_) {
+    if (slot.fence) {
+      gl.glDeleteSync(slot.fence);
+    }
+    if (slot.buffer) {
+      gl.glDeleteBuffers(1, &slot.buffer);
+    }
+  }
+}
+
+uint8_t* UploadBufferRing::Map(size_t size) {
+  const auto& gl = GlProcs();
+  if (!gl.valid || size == 0) {
+    return nullptr;
+  }
+
+  auto& slot = slots_[index_];
+  if (slot.fence) {
+    // The previous uploads from this buffer must finish before it is
+    // overwritten. This runs in client requests, so the fence is only polled.
+    // e.g. more than |kSlotCount| commits in one dispatch find it unsignaled.
+    auto result =
+        gl.glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    gl.glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+      // GL may still read the buffer, so it must not be overwritten. It's
+      // orphaned instead, i.e. deleted and replaced by a new one. GL frees
+      // its storage after the pending uploads finish.
+      if (result == GL_WAIT_FAILED) {
+        WAFFLE_LOG(WARNING) << "Failed to wait for the upload buffer";
+      }
+      gl.glDeleteBuffers(1, &slot.buffer);
+      slot.buffer = 0;
+      slot.capacity = 0;
+      slot.mapped = nullptr;
+    }
+  }
+
+  if (!Reserve(slot, size)) {
+    gl.glBindBuffer(target_, 0);
+    return nullptr;
+  }
+
+  if (persistent_) {
+    return slot.mapped;
+  }
+
+  // The fence above guarantees that GL no longer reads the buffer.
+  auto* mapped = gl.glMapBufferRange(
+      target_, 0, size,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+          GL_MAP_UNSYNCHRONIZED_BIT);
+  if (!mapped) {
+    WAFFLE_LOG(ERROR) << "Failed to map the upload buffer";
+    gl.glBindBuffer(target_, 0);
+    return nullptr;
+  }
+  return static_cast<uint8_t*>(mapped);
+}
+
+void UploadBufferRing::Unmap() {
+  const auto& gl = GlProcs();
+  if (!gl.valid || persistent_) {
+    return;
+  }
+  gl.glUnmapBuffer(target_);
+}
+
+void UploadBufferRing::Submit() {
+  const auto& gl = GlProcs();
+  if (!gl.valid) {
+    return;
+  }
+
+  auto& slot = slots_[index_];
+  slot.fence = gl.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  gl.glBindBuffer(target_, 0);
+  index_ = (index_ + 1) % kSlotCount;
+}
+
+bool UploadBufferRing::Reserve(Slot& slot, size_t size) {
+  const auto& gl = GlProcs();
+
+  if (slot.buffer && slot.capacity >= size) {
+    gl.glBindBuffer(target_, slot.buffer);
+    return true;
+  }
+
+  auto capacity = (size + kCapacityAlignment - 1) / kCapacityAlignment *
+                  kCapacityAlignment;
+  if (persistent_) {
+    // The storage of GL_EXT_buffer_storage is immutable, so the buffer
+    // itself is recreated.
+    if (slot.buffer) {
+      gl.glDeleteBuffers(1, &slot.buffer);
+    }
+    gl.glGenBuffers(1, &slot.buffer);
+    gl.glBindBuffer(target_, slot.buffer);
+
+    const GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+    gl.glBufferStorageEXT(target_, capacity, nullptr, flags);
+    slot.mapped = static_cast<uint8_t*>(
+        gl.glMapBufferRange(target_, 0, capacity, flags));
+    if (!slot.mapped) {
+      WAFFLE_LOG(ERROR) << "Failed to map the upload buffer persistently";
+      gl.glDeleteBuffers(1, &slot.buffer);
+      slot.buffer = 0;
+      slot.capacity = 0;
+      return false;
+    }
+  } else {
+    if (!slot.buffer) {
+      gl.glGenBuffers(1, &slot.buffer);
+    }
+    gl.glBindBuffer(target_, slot.buffer);
+    gl.glBufferData(target_, capacity, nullptr, GL_STREAM_DRAW);
+  }
+  slot.capacity = capacity;
+  return true;
+}
+
+}  // namespace waffle
@@ -0,0 +1,68 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_RENDERER_UPLOAD_BUFFER_RING_H_
+#define WAFFLE_RENDERER_UPLOAD_BUFFER_RING_H_
+
+#include <GLES3/gl32.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace waffle {
+
+// Ring of buffers used to stream data to GL. e.g. client pixels are copied
+// into the next buffer of the ring on the CPU and the texture uploads are
+// sourced from the buffer, so that GL copies them asynchronously. The buffers
+// are persistently mapped when GL_EXT_buffer_storage is available.
+class UploadBufferRing {
+ public:
+  // Returns the ring of GL_PIXEL_UNPACK_BUFFER for the texture uploads.
+  static UploadBufferRing& Instance();
+
+  // Creates a ring of buffers which are bound to |target|. The GL context
+  // must be current.
+  explicit UploadBufferRing(GLenum target);
+  ~UploadBufferRing();
+
+  // Prevent copying.
+  UploadBufferRing(UploadBufferRing const&) = delete;
+  UploadBufferRing& operator=(UploadBufferRing const&) = delete;
+
+  // Returns a pointer to |size| writable bytes of the next buffer in the ring,
+  // or nullptr on failure. This never waits for the GPU. A buffer which GL
+  // still reads is replaced by a new one instead. The buffer is bound to the target until Submit() is
+  // called, so the offsets in the buffer are passed to GL instead of
+  // pointers.
+  uint8_t* Map(size_t size);
+
+  // Makes the written pixels visible to GL.
+  void Unmap();
+
+  // Fences the GL commands sourced from the current buffer and moves to the
+  // next buffer.
+  void Submit();
+
+ private:
+  struct Slot {
+    GLuint buffer = 0;
+    size_t capacity = 0;
+    uint8_t* mapped = nullptr;
+    GLsync fence = nullptr;
+  };
+
+  static constexpr size_t kSlotCount = 3;
+
+  bool Reserve(Slot& slot, size_t size);
+
+  GLenum target_;
+  std::array<Slot, kSlotCount> slots_;
+  size_t index_ = 0;
+  bool persistent_ = false;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_RENDERER_UPLOAD_BUFFER_RING_H_
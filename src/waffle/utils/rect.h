@@ -0,0 +1,129 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_UTILS_RECT_H_
+#define WAFFLE_UTILS_RECT_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "waffle/utils/vec2.h"
+
+namespace waffle {
+
+// Axis-aligned rectangle. The origin is the top-left corner.
+template <typename T>
+class Rect {
+ public:
+  Rect() : x_(0), y_(0), width_(0), height_(0) {}
+  Rect(T x, T y, T width, T height)
+      : x_(x), y_(y), width_(width), height_(height) {}
+  ~Rect() = default;
+
+  T X() const { return x_; }
+  T Y() const { return y_; }
+  T Width() const { return width_; }
+  T Height() const { return height_; }
+  T Right() const { return x_ + width_; }
+  T Bottom() const { return y_ + height_; }
+
+  bool IsEmpty() const { return width_ <= 0 || height_ <= 0; }
+
+  bool Contains(T x, T y) const {
+    return x >= x_ && y >= y_ && x < Right() && y < Bottom();
+  }
+
+  bool Contains(const Rect& rect) const {
+    return !rect.IsEmpty() && rect.x_ >= x_ && rect.y_ >= y_ &&
+           rect.Right() <= Right() && rect.Bottom() <= Bottom();
+  }
+
+  bool Intersects(const Rect& rect) const {
+    return !Intersect(rect).IsEmpty();
+  }
+
+  // Returns the overlapping area of both rectangles.
+  Rect Intersect(const Rect& rect) const {
+    auto left = std::max(x_, rect.x_);
+    auto top = std::max(y_, rect.y_);
+    auto right = std::min(Right(), rect.Right());
+    auto bottom = std::min(Bottom(), rect.Bottom());
+    if (right <= left || bottom <= top) {
+      return Rect();
+    }
+    return Rect(left, top, right - left, bottom - top);
+  }
+
+  // Returns the bounding box of both rectangles.
+  Rect Union(const Rect& rect) const {
+    if (IsEmpty()) {
+      return rect;
+    }
+    if (rect.IsEmpty()) {
+      return *this;
+    }
+    auto left = std::min(x_, rect.x_);
+    auto top = std::min(y_, rect.y_);
+    auto right = std::max(Right(), rect.Right());
+    auto bottom = std::max(Bottom(), rect.Bottom());
+    return Rect(left, top, right - left, bottom - top);
+  }
+
+  bool operator==(const Rect& rect) const {
+    return x_ == rect.x_ && y_ == rect.y_ && width_ == rect.width_ &&
+           height_ == rect.height_;
+  }
+
+  bool operator!=(const Rect& rect) const { return !(*this == rect); }
+
+ private:
+  T x_, y_, width_, height_;
+};
+
+// Returns the part of a rectangle sent by a client which is between |min| and
+// |max|. The values are arbitrary, so the edges are computed in 64-bit to
+// avoid overflows. Negative sizes result in an empty rectangle.
+inline Rect<int> ClampClientRect(int32_t x,
+                                 int32_t y,
+                                 int32_t width,
+                                 int32_t height,
+                                 Vec2<int> min,
+                                 Vec2<int> max) {
+  auto left = std::max<int64_t>(x, min.X());
+  auto top = std::max<int64_t>(y, min.Y());
+  auto right = std::min<int64_t>(static_cast<int64_t>(x) + width, max.X());
+  auto bottom = std::min<int64_t>(static_cast<int64_t>(y) + height, max.Y());
+  if (right <= left || bottom <= top) {
+    return Rect<int>();
+  }
+  return Rect<int>(static_cast<int>(left), static_cast<int>(top),
+                   static_cast<int>(right - left),
+                   static_cast<int>(bottom - top));
+}
+
+// Returns the part of a rectangle sent by a client which is inside a surface
+// of |size|.
+inline Rect<int> ClampClientRect(int32_t x,
+                                 int32_t y,
+                                 int32_t width,
+                                 int32_t height,
+                                 Vec2<int> size) {
+  return ClampClientRect(x, y, width, height, Vec2<int>(0, 0), size);
+}
+
+// Returns a rectangle sent by a client without bounds, e.g. of a wl_region.
+// It's saturated so that neither its edges nor its size overflow int.
+inline Rect<int> ClampClientRect(int32_t x,
+                                 int32_t y,
+                                 int32_t width,
+                                 int32_t height) {
+  constexpr int kLimit = std::numeric_limits<int>::max() / 2;
+  return ClampClientRect(x, y, width, height, Vec2<int>(-kLimit, -kLimit),
+                         Vec2<int>(kLimit, kLimit));
+}
+
+}  // namespace waffle
+
+#endif  // WAFFLE_UTILS_RECT_H_
@@ -0,0 +1,247 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/utils/region.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace waffle {
+
+namespace {
+
+// Horizontal spans [left, right) of a band, sorted by x.
+using Spans = std::vector<std::pair<int, int>>;
+
+// Returns the spans of the band in |rects| which covers the row |y|. |index|
+// is the first rectangle which may cover |y|, and it's advanced past the
+// bands above |y|. So, |y| must not decrease between calls.
+Spans SpansAt(const std::vector<Rect<int>>& rects, size_t& index, int y) {
+  while (index < rects.size() && rects[index].Bottom() <= y) {
+    index++;
+  }
+
+  Spans spans;
+  if (index == rects.size() || rects[index].Y() > y) {
+    return spans;
+  }
+  auto top = rects[index].Y();
+  for (auto i = index; i < rects.size() && rects[i].Y() == top; i++) {
+    spans.emplace_back(rects[i].X(), rects[i].Right());
+  }
+  return spans;
+}
+
+}  // namespace
+
+Region::Region(const Rect<int>& rect) {
+  Union(rect);
+}
+
+void Region::Clear() {
+  rects_.clear();
+  extents_ = Rect<int>();
+}
+
+void Region::Union(const Rect<int>& rect) {
+  if (rect.IsEmpty() || Contains(rect)) {
+    return;
+  }
+  if (rects_.empty()) {
+    rects_.push_back(rect);
+    extents_ = rect;
+    return;
+  }
+  Combine({rect}, Op::kUnion);
+}
+
+void Region::Union(const Region& region) {
+  if (region.IsEmpty()) {
+    return;
+  }
+  Combine(region.rects_, Op::kUnion);
+}
+
+void Region::Subtract(const Rect<int>& rect) {
+  if (!extents_.Intersects(rect)) {
+    return;
+  }
+  Combine({rect}, Op::kSubtract);
+}
+
+void Region::Subtract(const Region& region) {
+  if (!extents_.Intersects(region.extents_)) {
+    return;
+  }
+  Combine(region.rects_, Op::kSubtract);
+}
+
+void Region::Intersect(const Rect<int>& rect) {
+  if (extents_.IsEmpty() || rect.Contains(extents_)) {
+    return;
+  }
+  if (rect.IsEmpty()) {
+    Clear();
+    return;
+  }
+  Combine({rect}, Op::kIntersect);
+}
+
+void Region::Intersect(const Region& region) {
+  Combine(region.rects_, Op::kIntersect);
+}
+
+void Region::Translate(int dx, int dy) {
+  for (auto& rect : rects_) {
+    rect = Rect<int>(rect.X() + dx, rect.Y() + dy, rect.Width(),
+                     rect.Height());
+  }
+  UpdateExtents();
+}
+
+bool Region::Contains(int x, int y) const {
+  if (!extents_.Contains(x, y)) {
+    return false;
+  }
+
+  // The first rectangle of the band which may cover |y|. Bottoms of the
+  // rectangles never decrease.
+  auto band = std::upper_bound(
+      rects_.begin(), rects_.end(), y,
+      [](int y, const Rect<int>& rect) { return y < rect.Bottom(); });
+  if (band == rects_.end() || band->Y() > y) {
+    return false;
+  }
+  auto band_end = std::upper_bound(
+      band, rects_.end(), band->Y(),
+      [](int top, const Rect<int>& rect) { return top < rect.Y(); });
+
+  // The first rectangle in the band which ends on the right of |x|.
+  auto rect = std::upper_bound(
+      band, band_end, x,
+      [](int x, const Rect<int>& rect) { return x < rect.Right(); });
+  return rect != band_end && rect->X() <= x;
+}
+
+bool Region::Contains(const Rect<int>& rect) const {
+  if (!extents_.Contains(rect)) {
+    return rect.IsEmpty();
+  }
+
+  Region outside(rect);
+  outside.Subtract(*this);
+  return outside.IsEmpty();
+}
+
+void Region::Combine(const std::vector<Rect<int>>& rects, Op op) {
+  auto in_result = [op](bool in_a, bool in_b) {
+    switch (op) {
+      case Op::kUnion:
+        return in_a || in_b;
+      case Op::kIntersect:
+        return in_a && in_b;
+      case Op::kSubtract:
+        return in_a && !in_b;
+    }
+    return false;
+  };
+
+  // Every row between two adjacent edges is covered by at most one band of
+  // each region.
+  std::vector<int> ys;
+  ys.reserve((rects_.size() + rects.size()) * 2);
+  for (const auto& rect : rects_) {
+    ys.push_back(rect.Y());
+    ys.push_back(rect.Bottom());
+  }
+  for (const auto& rect : rects) {
+    ys.push_back(rect.Y());
+    ys.push_back(rect.Bottom());
+  }
+  std::sort(ys.begin(), ys.end());
+  ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+  std::vector<Rect<int>> result;
+  size_t index_a = 0;
+  size_t index_b = 0;
+  Spans last_spans;
+  size_t last_band = 0;
+  auto last_bottom = std::numeric_limits<int>::min();
+  for (size_t i = 0; i + 1 < ys.size(); i++) {
+    auto top = ys[i];
+    auto bottom = ys[i + 1];
+    auto spans_a = SpansAt(rects_, index_a, top);
+    auto spans_b = SpansAt(rects, index_b, top);
+    if (spans_a.empty() && spans_b.empty()) {
+      continue;
+    }
+
+    std::vector<int> xs;
+    for (const auto& span : spans_a) {
+      xs.push_back(span.first);
+      xs.push_back(span.second);
+    }
+    for (const auto& span : spans_b) {
+      xs.push_back(span.first);
+      xs.push_back(span.second);
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+
+    Spans spans;
+    size_t span_a = 0;
+    size_t span_b = 0;
+    for (size_t j = 0; j + 1 < xs.size(); j++) {
+      auto left = xs[j];
+      while (span_a < spans_a.size() && spans_a[span_a].second <= left) {
+        span_a++;
+      }
+      while (span_b < spans_b.size() && spans_b[span_b].second <= left) {
+        span_b++;
+      }
+      auto in_a = span_a < spans_a.size() && spans_a[span_a].first <= left;
+      auto in_b = span_b < spans_b.size() && spans_b[span_b].first <= left;
+      if (!in_result(in_a, in_b)) {
+        continue;
+      }
+      if (!spans.empty() && spans.back().second == left) {
+        spans.back().second = xs[j + 1];
+      } else {
+        spans.emplace_back(left, xs[j + 1]);
+      }
+    }
+    if (spans.empty()) {
+      continue;
+    }
+
+    if (last_bottom == top && spans == last_spans) {
+      // Extends the band above instead of adding an identical one.
+      for (auto k = last_band; k < result.size(); k++) {
+        auto& rect = result[k];
+        rect = Rect<int>(rect.X(), rect.Y(), rect.Width(), bottom - rect.Y());
+      }
+    } else {
+      last_band = result.size();
+      for (const auto& span : spans) {
+        result.emplace_back(span.first, top, span.second - span.first,
+                            bottom - top);
+      }
+      last_spans.swap(spans);
+    }
+    last_bottom = bottom;
+  }
+
+  rects_.swap(result);
+  UpdateExtents();
+}
+
+void Region::UpdateExtents() {
+  extents_ = Rect<int>();
+  for (const auto& rect : rects_) {
+    extents_ = extents_.Union(rect);
+  }
+}
+
+}  // namespace waffle
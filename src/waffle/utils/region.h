@@ -0,0 +1,87 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_UTILS_REGION_H_
+#define WAFFLE_UTILS_REGION_H_
+
+#include <vector>
+
+#include "waffle/utils/rect.h"
+
+namespace waffle {
+
+// An area made of rectangles. This is used for damaged, opaque and input
+// areas.
+//
+// The rectangles are kept y-banded like pixman regions: they are sorted by
+// y and then x, rectangles in the same band have the same top and bottom,
+// and they never overlap each other. Adjacent rectangles in a band and
+// identical adjacent bands are merged, so the same area is always
+// represented by the same rectangles.
+class Region {
+ public:
+  Region() = default;
+  explicit Region(const Rect<int>& rect);
+  ~Region() = default;
+
+  bool IsEmpty() const { return rects_.empty(); }
+
+  void Clear();
+
+  void Union(const Rect<int>& rect);
+
+  void Union(const Region& region);
+
+  // Removes the area of |rect| from the region.
+  void Subtract(const Rect<int>& rect);
+
+  void Subtract(const Region& region);
+
+  // Clips all rectangles to |rect|.
+  void Intersect(const Rect<int>& rect);
+
+  // Leaves only the area which is also in |region|.
+  void Intersect(const Region& region);
+
+  // Moves the region by (|dx|, |dy|).
+  void Translate(int dx, int dy);
+
+  // Returns true if the pixel at (|x|, |y|) is in the region. This takes
+  // O(log n) time.
+  bool Contains(int x, int y) const;
+
+  // Returns true if the whole area of |rect| is in the region.
+  bool Contains(const Rect<int>& rect) const;
+
+  // Returns the bounding box of the region.
+  Rect<int> Extents() const { return extents_; }
+
+  const std::vector<Rect<int>>& Rects() const { return rects_; }
+
+  bool operator==(const Region& region) const {
+    return rects_ == region.rects_;
+  }
+
+  bool operator!=(const Region& region) const { return !(*this == region); }
+
+ private:
+  enum class Op {
+    kUnion,
+    kIntersect,
+    kSubtract,
+  };
+
+  // Replaces the rectangles with the result of |op| with |rects|, which is
+  // y-banded as well.
+  void Combine(const std::vector<Rect<int>>& rects, Op op);
+
+  void UpdateExtents();
+
+  std::vector<Rect<int>> rects_;
+  Rect<int> extents_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_UTILS_REGION_H_
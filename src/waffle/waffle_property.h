@@ -39,6 +39,13 @@ typedef struct {
   WaffleViewRotation view_rotation;
   bool use_mouse_cursor;
   std::string background_image_filepath;
+  // How long before the vblank the compositor starts drawing a frame, in
+  // milliseconds.
+  int32_t repaint_deadline_ms;
+  // How often the frame callbacks of hidden surfaces are sent, in
+  // milliseconds. They are withheld until the surfaces become visible if
+  // this is 0.
+  int32_t hidden_frame_callback_interval_ms;
 } WaffleWindowProperties;
 
 }  // namespace waffle
@@ -5,7 +5,11 @@
 #ifndef WAFFLE_WAYLAND_WAYLAND_BINDING_HANDLER_H_
 #define WAFFLE_WAYLAND_WAYLAND_BINDING_HANDLER_H_
 
+#include <wayland-server.h>
+
+#include "waffle/backend/surface/dmabuf_attributes.h"
 #include "waffle/renderer/texture.h"
+#include "waffle/utils/region.h"
 #include "waffle/utils/vec2.h"
 #include "waffle/wayland/wayland_binding_handler_delegate.h"
 
@@ -15,11 +19,13 @@ class WaylandBindingHandler {
  public:
   virtual void SetSize(Vec2<int> size) = 0;
   virtual std::weak_ptr<WaylandBindingHandlerDelegate> InputInterface() = 0;
-  void SetTexture(Texture texture) { texture_ = texture; }
-  Texture GetTexture() { return texture_; }
-
- private:
-  Texture texture_;
+  virtual Region TakeDamage() = 0;
+  virtual Texture GetTexture() = 0;
+  virtual const DmabufAttributes* GetDmabufAttributes() = 0;
+  virtual wl_resource* GetDmabufBuffer() = 0;
+  virtual Region OpaqueRegion() = 0;
+  virtual bool AcceptsInput(Vec2<double> pos) = 0;
+  virtual void SetVisible(bool visible) = 0;
 };
 
 };  // namespace waffle
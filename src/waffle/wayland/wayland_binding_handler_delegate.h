@@ -11,12 +11,31 @@
 
 namespace waffle {
 
+// Input events carry |time_usec|, the timestamp of the input device in
+// microseconds of CLOCK_MONOTONIC.
 class WaylandBindingHandlerDelegate {
  public:
-  virtual void OnPointerMove(Vec2<double> pos) = 0;
+  virtual void OnPointerMove(uint64_t time_usec, Vec2<double> pos) = 0;
+  virtual void OnPointerRelativeMotion(uint64_t time_usec,
+                                       Vec2<double> delta,
+                                       Vec2<double> delta_unaccel) = 0;
+  // Ends a group of pointer events which belong together. Motion events
+  // don't end their groups by themselves.
+  virtual void OnPointerFrame() = 0;
   virtual void OnPointerLeave() = 0;
-  virtual void OnPointerClick(uint32_t button, bool down) = 0;
-  virtual void OnKey(uint32_t key, bool down) = 0;
+  virtual void OnPointerClick(uint64_t time_usec,
+                              uint32_t button,
+                              bool down) = 0;
+  virtual void OnKey(uint64_t time_usec, uint32_t key, bool down) = 0;
+  virtual void OnKeyboardLeave() = 0;
+  virtual void OnTouchDown(uint64_t time_usec,
+                           int32_t id,
+                           Vec2<double> pos) = 0;
+  virtual void OnTouchUp(uint64_t time_usec, int32_t id) = 0;
+  virtual void OnTouchMotion(uint64_t time_usec,
+                             int32_t id,
+                             Vec2<double> pos) = 0;
+  virtual void OnTouchCancel() = 0;
 };
 
 };  // namespace waffle
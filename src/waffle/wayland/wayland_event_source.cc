@@ -0,0 +1,75 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/wayland/wayland_event_source.h"
+
+#include <algorithm>
+
+#include "waffle/logger.h"
+
+namespace waffle {
+
+WaylandEventSource::~WaylandEventSource() {
+  Remove();
+}
+
+bool WaylandEventSource::AddFd(wl_display* display,
+                               int fd,
+                               wl_event_loop_fd_func_t func,
+                               void* data) {
+  auto* loop = wl_display_get_event_loop(display);
+  return Attach(display, wl_event_loop_add_fd(loop, fd, WL_EVENT_READABLE,
+                                              func, data));
+}
+
+bool WaylandEventSource::AddTimer(wl_display* display,
+                                  wl_event_loop_timer_func_t func,
+                                  void* data) {
+  auto* loop = wl_display_get_event_loop(display);
+  return Attach(display, wl_event_loop_add_timer(loop, func, data));
+}
+
+void WaylandEventSource::Arm(std::chrono::nanoseconds delay) {
+  if (!source_) {
+    return;
+  }
+  // Zero disarms the timer, so it expires after 1 ms at least.
+  auto msec = std::chrono::ceil<std::chrono::milliseconds>(delay).count();
+  wl_event_source_timer_update(source_, std::max<int64_t>(msec, 1));
+}
+
+void WaylandEventSource::Disarm() {
+  if (!source_) {
+    return;
+  }
+  wl_event_source_timer_update(source_, 0);
+}
+
+void WaylandEventSource::Remove() {
+  if (!source_) {
+    return;
+  }
+  wl_event_source_remove(source_);
+  source_ = nullptr;
+  wl_list_remove(&display_destroy_listener_.link);
+}
+
+bool WaylandEventSource::Attach(wl_display* display, wl_event_source* source) {
+  Remove();
+  if (!source) {
+    WAFFLE_LOG(ERROR) << "Failed to add an event source.";
+    return false;
+  }
+
+  source_ = source;
+  display_destroy_listener_.notify = [](wl_listener* listener, void* data) {
+    WaylandEventSource* self =
+        wl_container_of(listener, self, display_destroy_listener_);
+    self->Remove();
+  };
+  wl_display_add_destroy_listener(display, &display_destroy_listener_);
+  return true;
+}
+
+}  // namespace waffle
@@ -0,0 +1,53 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_WAYLAND_WAYLAND_EVENT_SOURCE_H_
+#define WAFFLE_WAYLAND_WAYLAND_EVENT_SOURCE_H_
+
+#include <wayland-server-core.h>
+
+#include <chrono>
+
+namespace waffle {
+
+// A source of the wl_event_loop of a wl_display. Everything in the compositor
+// is driven by the sources of the loop. The source is removed when this is
+// destroyed, or when the display is destroyed if that's earlier.
+class WaylandEventSource {
+ public:
+  WaylandEventSource() = default;
+  ~WaylandEventSource();
+
+  WaylandEventSource(const WaylandEventSource&) = delete;
+  WaylandEventSource& operator=(const WaylandEventSource&) = delete;
+
+  // Calls |func| when |fd| gets readable.
+  bool AddFd(wl_display* display,
+             int fd,
+             wl_event_loop_fd_func_t func,
+             void* data);
+
+  // Adds a timer which is disarmed until Arm() is called.
+  bool AddTimer(wl_display* display,
+                wl_event_loop_timer_func_t func,
+                void* data);
+
+  // Arms the timer to expire after |delay|. The timer has the resolution of
+  // milliseconds, and |delay| is rounded up.
+  void Arm(std::chrono::nanoseconds delay);
+
+  void Disarm();
+
+  void Remove();
+
+ private:
+  bool Attach(wl_display* display, wl_event_source* source);
+
+  wl_event_source* source_ = nullptr;
+  wl_listener display_destroy_listener_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_WAYLAND_WAYLAND_EVENT_SOURCE_H_
@@ -0,0 +1,120 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/wayland/wayland_keymap.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "waffle/logger.h"
+
+namespace waffle {
+
+namespace {
+// Keycodes of xkb are offset by 8 from the evdev ones.
+constexpr uint32_t kEvdevKeycodeOffset = 8;
+}  // namespace
+
+WaylandKeymap::WaylandKeymap() {
+  context_ = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+  if (!context_) {
+    WAFFLE_LOG(ERROR) << "Failed to create xkb context.";
+    return;
+  }
+
+  keymap_ = xkb_keymap_new_from_names(context_, nullptr,
+                                      XKB_KEYMAP_COMPILE_NO_FLAGS);
+  if (!keymap_) {
+    WAFFLE_LOG(ERROR) << "Failed to compile xkb keymap.";
+    return;
+  }
+
+  state_ = xkb_state_new(keymap_);
+  if (!state_) {
+    WAFFLE_LOG(ERROR) << "Failed to create xkb state.";
+    return;
+  }
+
+  auto* keymap_string =
+      xkb_keymap_get_as_string(keymap_, XKB_KEYMAP_FORMAT_TEXT_V1);
+  if (!keymap_string) {
+    WAFFLE_LOG(ERROR) << "Failed to get xkb keymap string.";
+    return;
+  }
+  CreateKeymapFile(keymap_string);
+  free(keymap_string);
+}
+
+WaylandKeymap::~WaylandKeymap() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  if (state_) {
+    xkb_state_unref(state_);
+  }
+  if (keymap_) {
+    xkb_keymap_unref(keymap_);
+  }
+  if (context_) {
+    xkb_context_unref(context_);
+  }
+}
+
+void WaylandKeymap::UpdateKey(uint32_t key, bool down) {
+  if (!state_) {
+    return;
+  }
+
+  xkb_state_update_key(state_, key + kEvdevKeycodeOffset,
+                       down ? XKB_KEY_DOWN : XKB_KEY_UP);
+  modifiers_.depressed =
+      xkb_state_serialize_mods(state_, XKB_STATE_MODS_DEPRESSED);
+  modifiers_.latched = xkb_state_serialize_mods(state_, XKB_STATE_MODS_LATCHED);
+  modifiers_.locked = xkb_state_serialize_mods(state_, XKB_STATE_MODS_LOCKED);
+  modifiers_.group =
+      xkb_state_serialize_layout(state_, XKB_STATE_LAYOUT_EFFECTIVE);
+}
+
+bool WaylandKeymap::CreateKeymapFile(const char* keymap_string) {
+  auto size = strlen(keymap_string) + 1;
+  auto fd = memfd_create("waffle-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    WAFFLE_LOG(ERROR) << "Failed to create keymap file: " << strerror(errno);
+    return false;
+  }
+
+  size_t written = 0;
+  while (written < size) {
+    auto ret = write(fd, keymap_string + written, size - written);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      WAFFLE_LOG(ERROR) << "Failed to write keymap file: " << strerror(errno);
+      close(fd);
+      return false;
+    }
+    written += ret;
+  }
+
+  // Clients can only map the file read-only once it's sealed, so the keymap
+  // can safely be shared between them.
+  if (fcntl(fd, F_ADD_SEALS,
+            F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+    WAFFLE_LOG(ERROR) << "Failed to seal keymap file: " << strerror(errno);
+    close(fd);
+    return false;
+  }
+
+  fd_ = fd;
+  size_ = size;
+  return true;
+}
+
+}  // namespace waffle
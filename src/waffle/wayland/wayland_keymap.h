@@ -0,0 +1,68 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_WAYLAND_WAYLAND_KEYMAP_H_
+#define WAFFLE_WAYLAND_WAYLAND_KEYMAP_H_
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <cstdint>
+
+namespace waffle {
+
+// The xkb keymap of the seat and its keyboard state.
+//
+// The keymap is compiled once and written into a sealed memfd, so all
+// clients map the same read-only file through wl_keyboard.keymap instead of
+// getting their own copy.
+class WaylandKeymap {
+ public:
+  struct Modifiers {
+    uint32_t depressed = 0;
+    uint32_t latched = 0;
+    uint32_t locked = 0;
+    uint32_t group = 0;
+
+    bool operator==(const Modifiers& mods) const {
+      return depressed == mods.depressed && latched == mods.latched &&
+             locked == mods.locked && group == mods.group;
+    }
+
+    bool operator!=(const Modifiers& mods) const { return !(*this == mods); }
+  };
+
+  // Compiles the default keymap. The XKB_DEFAULT_* environment variables are
+  // used to choose the layout.
+  WaylandKeymap();
+  ~WaylandKeymap();
+
+  // Prevent copying.
+  WaylandKeymap(WaylandKeymap const&) = delete;
+  WaylandKeymap& operator=(WaylandKeymap const&) = delete;
+
+  bool IsValid() const { return fd_ >= 0; }
+
+  // The sealed memfd which has the keymap string with the terminating null.
+  int Fd() const { return fd_; }
+  uint32_t Size() const { return size_; }
+
+  // Updates the keyboard state with the evdev |key|.
+  void UpdateKey(uint32_t key, bool down);
+
+  Modifiers GetModifiers() const { return modifiers_; }
+
+ private:
+  bool CreateKeymapFile(const char* keymap_string);
+
+  xkb_context* context_ = nullptr;
+  xkb_keymap* keymap_ = nullptr;
+  xkb_state* state_ = nullptr;
+  int fd_ = -1;
+  uint32_t size_ = 0;
+  Modifiers modifiers_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_WAYLAND_WAYLAND_KEYMAP_H_
@@ -0,0 +1,360 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/wayland/wayland_linux_dmabuf.h"
+
+#include <unistd.h>
+#include <wayland/protocols/linux-dmabuf-unstable-v1-server-protocol.h>
+#include <wayland/protocols/wayland-server-protocol.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "waffle/compositor/compositor.h"
+#include "waffle/logger.h"
+
+namespace waffle {
+
+namespace {
+
+void CloseFds(DmabufAttributes& attributes) {
+  for (auto& plane : attributes.planes) {
+    if (plane.fd >= 0) {
+      close(plane.fd);
+      plane.fd = -1;
+    }
+  }
+}
+
+// wl_buffer which consists of dmabuf planes.
+struct DmabufBuffer : WaylandResource::Data {
+  WaylandResource resource;
+  DmabufAttributes attributes;
+
+  ~DmabufBuffer() { CloseFds(attributes); }
+
+  static const struct wl_buffer_interface kWlBufferInterface;
+};
+
+const struct wl_buffer_interface DmabufBuffer::kWlBufferInterface {
+  .destroy = +[](wl_client* client, wl_resource* resource) {
+    WAFFLE_LOG(TRACE) << "wl_buffer_interface.destroy is called.";
+    WaylandResource(resource).Destroy();
+  },
+};
+
+struct BufferParams : WaylandResource::Data {
+  WaylandResource resource;
+  DmabufAttributes attributes;
+  bool used = false;
+
+  ~BufferParams() { CloseFds(attributes); }
+
+  // Checks the added planes. Posts a protocol error and returns false if they
+  // are invalid.
+  bool Validate(int32_t width, int32_t height);
+
+  // Creates a wl_buffer from the validated planes. Returns nullptr if the
+  // buffer can't be imported.
+  wl_resource* CreateBuffer(wl_client* client,
+                            uint32_t buffer_id,
+                            int32_t width,
+                            int32_t height,
+                            uint32_t format,
+                            uint32_t flags);
+
+  static const struct zwp_linux_buffer_params_v1_interface
+      kBufferParamsInterface;
+};
+
+bool BufferParams::Validate(int32_t width, int32_t height) {
+  auto* params = resource.Resource();
+  if (used) {
+    wl_resource_post_error(params,
+                           ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_ALREADY_USED,
+                           "params was already used to create a wl_buffer");
+    return false;
+  }
+  used = true;
+
+  if (attributes.num_planes == 0) {
+    wl_resource_post_error(params, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INCOMPLETE,
+                           "no dmabuf has been added to the params");
+    return false;
+  }
+  for (int i = 0; i < attributes.num_planes; i++) {
+    if (attributes.planes[i].fd < 0) {
+      wl_resource_post_error(params,
+                             ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INCOMPLETE,
+                             "no dmabuf has been added for plane %i", i);
+      return false;
+    }
+  }
+
+  if (width < 1 || height < 1) {
+    wl_resource_post_error(params,
+                           ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INVALID_DIMENSIONS,
+                           "invalid width %d or height %d", width, height);
+    return false;
+  }
+
+  for (int i = 0; i < attributes.num_planes; i++) {
+    const auto& plane = attributes.planes[i];
+    if (static_cast<uint64_t>(plane.offset) + plane.stride > UINT32_MAX ||
+        (i == 0 && static_cast<uint64_t>(plane.offset) +
+                           static_cast<uint64_t>(plane.stride) * height >
+                       UINT32_MAX)) {
+      wl_resource_post_error(params,
+                             ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_OUT_OF_BOUNDS,
+                             "size overflow for plane %i", i);
+      return false;
+    }
+
+    // Not all kernels support seeking on dmabufs.
+    auto size = lseek(plane.fd, 0, SEEK_END);
+    if (size == -1) {
+      continue;
+    }
+    if (plane.offset >= size ||
+        static_cast<uint64_t>(plane.offset) + plane.stride >
+            static_cast<uint64_t>(size) ||
+        (i == 0 && static_cast<uint64_t>(plane.offset) +
+                           static_cast<uint64_t>(plane.stride) * height >
+                       static_cast<uint64_t>(size))) {
+      wl_resource_post_error(params,
+                             ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_OUT_OF_BOUNDS,
+                             "invalid offset or stride for plane %i", i);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+wl_resource* BufferParams::CreateBuffer(wl_client* client,
+                                        uint32_t buffer_id,
+                                        int32_t width,
+                                        int32_t height,
+                                        uint32_t format,
+                                        uint32_t flags) {
+  if (flags != 0) {
+    WAFFLE_LOG(WARNING) << "dmabuf flags are not supported: " << flags;
+  }
+
+  // The buffer takes over the file descriptors.
+  auto buffer = std::make_shared<DmabufBuffer>();
+  buffer->attributes = attributes;
+  buffer->attributes.width = width;
+  buffer->attributes.height = height;
+  buffer->attributes.format = format;
+  buffer->attributes.flags = flags;
+  for (auto& plane : attributes.planes) {
+    plane.fd = -1;
+  }
+  buffer->resource.Create(buffer, client, buffer_id, &wl_buffer_interface, 1,
+                          &DmabufBuffer::kWlBufferInterface);
+
+  // Import the buffer now to tell the client whether it can be used. The
+  // import is cached, so attaching the buffer later doesn't import it again.
+  // |texture| only receives the cached texture.
+  auto texture = Texture::Empty();
+  auto* compositor = waffle::Compositor::Instance();
+  if (!compositor->LoadDmabufIntoTexture(buffer->resource.Resource(),
+                                         buffer->attributes, texture)) {
+    buffer->resource.Destroy();
+    return nullptr;
+  }
+  return buffer->resource.Resource();
+}
+
+const struct zwp_linux_buffer_params_v1_interface
+    BufferParams::kBufferParamsInterface {
+  .destroy =
+      +[](wl_client* client, wl_resource* resource) {
+        WAFFLE_LOG(TRACE)
+            << "zwp_linux_buffer_params_v1_interface.destroy is called.";
+        WaylandResource(resource).Destroy();
+      },
+  .add =
+      +[](wl_client* client,
+          wl_resource* resource,
+          int32_t fd,
+          uint32_t plane_idx,
+          uint32_t offset,
+          uint32_t stride,
+          uint32_t modifier_hi,
+          uint32_t modifier_lo) {
+        WAFFLE_LOG(TRACE)
+            << "zwp_linux_buffer_params_v1_interface.add is called.";
+
+        auto params = WaylandResource(resource).Get<BufferParams>();
+        if (!params) {
+          WAFFLE_LOG(INFO) << "Resource is invalid.";
+          close(fd);
+          return;
+        }
+
+        if (params->used) {
+          wl_resource_post_error(
+              resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_ALREADY_USED,
+              "params was already used to create a wl_buffer");
+          close(fd);
+          return;
+        }
+
+        if (plane_idx >= kDmabufMaxPlanes) {
+          wl_resource_post_error(resource,
+                                 ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_PLANE_IDX,
+                                 "plane index %u is too high", plane_idx);
+          close(fd);
+          return;
+        }
+
+        auto& plane = params->attributes.planes[plane_idx];
+        if (plane.fd >= 0) {
+          wl_resource_post_error(resource,
+                                 ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_PLANE_SET,
+                                 "a dmabuf has already been added for plane %u",
+                                 plane_idx);
+          close(fd);
+          return;
+        }
+
+        plane.fd = fd;
+        plane.offset = offset;
+        plane.stride = stride;
+        plane.modifier =
+            (static_cast<uint64_t>(modifier_hi) << 32) | modifier_lo;
+        params->attributes.num_planes = std::max(
+            params->attributes.num_planes, static_cast<int>(plane_idx) + 1);
+      },
+  .create =
+      +[](wl_client* client,
+          wl_resource* resource,
+          int32_t width,
+          int32_t height,
+          uint32_t format,
+          uint32_t flags) {
+        WAFFLE_LOG(TRACE)
+            << "zwp_linux_buffer_params_v1_interface.create is called.";
+
+        auto params = WaylandResource(resource).Get<BufferParams>();
+        if (!params) {
+          WAFFLE_LOG(INFO) << "Resource is invalid.";
+          return;
+        }
+
+        if (!params->Validate(width, height)) {
+          return;
+        }
+        auto* buffer =
+            params->CreateBuffer(client, 0, width, height, format, flags);
+        if (buffer) {
+          zwp_linux_buffer_params_v1_send_created(resource, buffer);
+        } else {
+          zwp_linux_buffer_params_v1_send_failed(resource);
+        }
+      },
+  .create_immed = +[](wl_client* client,
+                      wl_resource* resource,
+                      uint32_t buffer_id,
+                      int32_t width,
+                      int32_t height,
+                      uint32_t format,
+                      uint32_t flags) {
+    WAFFLE_LOG(TRACE)
+        << "zwp_linux_buffer_params_v1_interface.create_immed is called.";
+
+    auto params = WaylandResource(resource).Get<BufferParams>();
+    if (!params) {
+      WAFFLE_LOG(INFO) << "Resource is invalid.";
+      return;
+    }
+
+    if (!params->Validate(width, height)) {
+      return;
+    }
+    auto* buffer =
+        params->CreateBuffer(client, buffer_id, width, height, format, flags);
+    if (!buffer) {
+      wl_resource_post_error(resource,
+                             ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INVALID_WL_BUFFER,
+                             "importing the supplied dmabufs failed");
+    }
+  },
+};
+
+}  // namespace
+
+struct WaylandLinuxDmabuf::Impl : WaylandResource::Data {
+  WaylandResource resource;
+
+  static const struct zwp_linux_dmabuf_v1_interface kLinuxDmabufInterface;
+};
+
+const struct zwp_linux_dmabuf_v1_interface
+    WaylandLinuxDmabuf::Impl::kLinuxDmabufInterface {
+  .destroy =
+      +[](wl_client* client, wl_resource* resource) {
+        WAFFLE_LOG(TRACE) << "zwp_linux_dmabuf_v1_interface.destroy is called.";
+        WaylandResource(resource).Destroy();
+      },
+  .create_params = +[](wl_client* client, wl_resource* resource, uint32_t id) {
+    WAFFLE_LOG(TRACE)
+        << "zwp_linux_dmabuf_v1_interface.create_params is called.";
+
+    auto params = std::make_shared<BufferParams>();
+    params->resource.Create(params, client, id,
+                            &zwp_linux_buffer_params_v1_interface,
+                            wl_resource_get_version(resource),
+                            &BufferParams::kBufferParamsInterface);
+  },
+};
+
+WaylandLinuxDmabuf::WaylandLinuxDmabuf(wl_client* client,
+                                       uint32_t id,
+                                       int32_t version) {
+  WAFFLE_LOG(TRACE) << "Creating WaylandLinuxDmabuf...";
+
+  auto impl = std::make_shared<Impl>();
+  impl->resource.Create(impl, client, id, &zwp_linux_dmabuf_v1_interface,
+                        version, &Impl::kLinuxDmabufInterface);
+  impl_ = impl;
+
+  auto* resource = impl->resource.Resource();
+  auto formats = waffle::Compositor::Instance()->QueryDmabufFormats();
+  for (const auto& format : formats) {
+    if (version < ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
+      zwp_linux_dmabuf_v1_send_format(resource, format.format);
+      continue;
+    }
+
+    if (format.modifiers.empty()) {
+      zwp_linux_dmabuf_v1_send_modifier(
+          resource, format.format, kDmabufModifierInvalid >> 32,
+          kDmabufModifierInvalid & 0xffffffff);
+      continue;
+    }
+    for (auto modifier : format.modifiers) {
+      zwp_linux_dmabuf_v1_send_modifier(resource, format.format,
+                                        modifier >> 32, modifier & 0xffffffff);
+    }
+  }
+}
+
+const DmabufAttributes* WaylandLinuxDmabuf::GetAttributes(
+    wl_resource* buffer) {
+  if (!wl_resource_instance_of(buffer, &wl_buffer_interface,
+                               &DmabufBuffer::kWlBufferInterface)) {
+    return nullptr;
+  }
+
+  auto dmabuf_buffer = WaylandResource(buffer).Get<DmabufBuffer>();
+  if (!dmabuf_buffer) {
+    return nullptr;
+  }
+  return &dmabuf_buffer->attributes;
+}
+
+}  // namespace waffle
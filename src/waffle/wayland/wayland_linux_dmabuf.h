@@ -0,0 +1,31 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_WAYLAND_WAYLAND_LINUX_DMABUF_H_
+#define WAFFLE_WAYLAND_WAYLAND_LINUX_DMABUF_H_
+
+#include "waffle/backend/surface/dmabuf_attributes.h"
+#include "waffle/wayland/wayland_resource.h"
+
+namespace waffle {
+
+constexpr uint kZwpLinuxDmabufV1MaxVersion = 3;
+
+class WaylandLinuxDmabuf {
+ public:
+  WaylandLinuxDmabuf(wl_client* client, uint32_t id, int32_t version);
+  ~WaylandLinuxDmabuf() = default;
+
+  // Returns the attributes of |buffer| if it was created by
+  // zwp_linux_dmabuf_v1. Otherwise, returns nullptr.
+  static const DmabufAttributes* GetAttributes(wl_resource* buffer);
+
+ private:
+  struct Impl;
+  std::weak_ptr<Impl> impl_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_WAYLAND_WAYLAND_LINUX_DMABUF_H_
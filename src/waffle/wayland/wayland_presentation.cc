@@ -0,0 +1,114 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/wayland/wayland_presentation.h"
+
+#include <time.h>
+#include <wayland/protocols/presentation-time-server-protocol.h>
+#include <wayland/protocols/wayland-server-protocol.h>
+
+#include <cstring>
+
+#include "waffle/logger.h"
+#include "waffle/wayland/wayland_surface.h"
+
+namespace waffle {
+
+struct WaylandPresentation::Impl : WaylandResource::Data {
+  WaylandResource resource;
+
+  static const struct wp_presentation_interface kPresentationInterface;
+};
+
+const struct wp_presentation_interface
+    WaylandPresentation::Impl::kPresentationInterface {
+  .destroy =
+      +[](wl_client* client, wl_resource* resource) {
+        WAFFLE_LOG(TRACE) << "wp_presentation_interface.destroy is called.";
+        WaylandResource(resource).Destroy();
+      },
+  .feedback = +[](wl_client* client,
+                  wl_resource* resource,
+                  wl_resource* surface,
+                  uint32_t callback) {
+    WAFFLE_LOG(TRACE) << "wp_presentation_interface.feedback is called.";
+
+    WaylandResource feedback;
+    feedback.Create(nullptr, client, callback,
+                    &wp_presentation_feedback_interface, 1, nullptr);
+    WaylandSurface::GetSurfaceFrom(WaylandResource(surface))
+        .AddPresentationFeedback(feedback);
+  },
+};
+
+WaylandPresentation::WaylandPresentation(wl_client* client,
+                                         uint32_t id,
+                                         int32_t version) {
+  WAFFLE_LOG(TRACE) << "Creating WaylandPresentation...";
+
+  auto impl = std::make_shared<Impl>();
+  impl->resource.Create(impl, client, id, &wp_presentation_interface, version,
+                        &Impl::kPresentationInterface);
+  impl_ = impl;
+
+  // The same clock as FrameClock::Clock.
+  wp_presentation_send_clock_id(impl->resource.Resource(), CLOCK_MONOTONIC);
+}
+
+void WaylandPresentation::SendPresented(WaylandResource feedback,
+                                        const FrameClock& clock,
+                                        bool zero_copy) {
+  if (!feedback.IsValid()) {
+    return;
+  }
+
+  // The frame is shown on the only output.
+  auto* resource = feedback.Resource();
+  wl_client_for_each_resource(
+      wl_resource_get_client(resource),
+      [](wl_resource* output, void* data) {
+        if (std::strcmp(wl_resource_get_class(output),
+                        wl_output_interface.name) == 0) {
+          wp_presentation_feedback_send_sync_output(
+              static_cast<wl_resource*>(data), output);
+        }
+        return WL_ITERATOR_CONTINUE;
+      },
+      resource);
+
+  const auto& presentation = clock.LastPresentation();
+  auto since_epoch = presentation.time.time_since_epoch();
+  auto sec = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+  auto nsec =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - sec);
+  uint64_t tv_sec = sec.count();
+  uint32_t flags = 0;
+  if (presentation.vsync) {
+    flags |= WP_PRESENTATION_FEEDBACK_KIND_VSYNC;
+  }
+  if (presentation.hw_clock) {
+    flags |= WP_PRESENTATION_FEEDBACK_KIND_HW_CLOCK;
+  }
+  if (presentation.hw_completion) {
+    flags |= WP_PRESENTATION_FEEDBACK_KIND_HW_COMPLETION;
+  }
+  if (zero_copy) {
+    flags |= WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY;
+  }
+  wp_presentation_feedback_send_presented(
+      resource, tv_sec >> 32, tv_sec & 0xffffffff, nsec.count(),
+      clock.RefreshInterval().count(), presentation.sequence >> 32,
+      presentation.sequence & 0xffffffff, flags);
+  feedback.Destroy();
+}
+
+void WaylandPresentation::SendDiscarded(WaylandResource feedback) {
+  if (!feedback.IsValid()) {
+    return;
+  }
+  wp_presentation_feedback_send_discarded(feedback.Resource());
+  feedback.Destroy();
+}
+
+}  // namespace waffle
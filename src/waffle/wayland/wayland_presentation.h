@@ -0,0 +1,37 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_WAYLAND_WAYLAND_PRESENTATION_H_
+#define WAFFLE_WAYLAND_WAYLAND_PRESENTATION_H_
+
+#include "waffle/backend/window/frame_clock.h"
+#include "waffle/wayland/wayland_resource.h"
+
+namespace waffle {
+
+constexpr uint kWpPresentationMaxVersion = 1;
+
+class WaylandPresentation {
+ public:
+  WaylandPresentation(wl_client* client, uint32_t id, int32_t version);
+  ~WaylandPresentation() = default;
+
+  // Sends wp_presentation_feedback.presented with the timing of the frame
+  // which contained the content update, and destroys |feedback|.
+  // |zero_copy| tells that the client buffer was scanned out directly.
+  static void SendPresented(WaylandResource feedback,
+                            const FrameClock& clock,
+                            bool zero_copy);
+
+  // Sends wp_presentation_feedback.discarded, and destroys |feedback|.
+  static void SendDiscarded(WaylandResource feedback);
+
+ private:
+  struct Impl;
+  std::weak_ptr<Impl> impl_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_WAYLAND_WAYLAND_PRESENTATION_H_
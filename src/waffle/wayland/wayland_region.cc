@@ -7,62 +7,13 @@
 #include <wayland/protocols/wayland-server-protocol.h>
 
 #include "waffle/logger.h"
+#include "waffle/utils/rect.h"
 #include "waffle/wayland/wayland_resource.h"
 
 namespace waffle {
 
-struct Area {
-  virtual bool Contains(double x, double y) = 0;
-};
-
-struct RectArea : Area {
-  double x_ = 0;
-  double y_ = 0;
-  double width_ = 0;
-  double height_ = 0;
-
-  RectArea(double x, double y, double width, double height)
-      : x_(x), y_(y), width_(width), height_(height) {}
-
-  bool Contains(double x, double y) {
-    return (x >= x_ && y >= y_) && (x <= (x_ + width_) && y <= (y_ + height_));
-  }
-};
-
-struct UnionArea : Area {
-  std::unique_ptr<Area> a_;
-  std::unique_ptr<Area> b_;
-
-  UnionArea(std::unique_ptr<Area> a, std::unique_ptr<Area> b)
-      : a_(std::move(a)), b_(std::move(b)) {}
-
-  bool Contains(double x, double y) {
-    return a_->Contains(x, y) || b_->Contains(x, y);
-  }
-};
-
-struct IntersectionArea : Area {
-  std::unique_ptr<Area> a_;
-  std::unique_ptr<Area> b_;
-
-  IntersectionArea(std::unique_ptr<Area> a, std::unique_ptr<Area> b)
-      : a_(std::move(a)), b_(std::move(b)) {}
-
-  bool Contains(double x, double y) {
-    return a_->Contains(x, y) && b_->Contains(x, y);
-  }
-};
-
-struct InverseArea : Area {
-  std::unique_ptr<Area> a_;
-
-  InverseArea(std::unique_ptr<Area> a) : a_(std::move(a)) {}
-
-  bool Contains(double x, double y) { return !a_->Contains(x, y); }
-};
-
 struct WaylandRegion::Impl : WaylandResource::Data {
-  std::unique_ptr<Area> data;
+  Region region;
   WaylandResource resource;
 
   static const struct wl_region_interface region_interface;
@@ -94,9 +45,7 @@ const struct wl_region_interface WaylandRegion::Impl::region_interface {
           return;
         }
 
-        auto rect = std::make_unique<RectArea>(x, y, width, height);
-        impl->data =
-            std::make_unique<UnionArea>(std::move(impl->data), std::move(rect));
+        impl->region.Union(ClampClientRect(x, y, width, height));
       },
   .subtract = +[](wl_client* client,
                   wl_resource* resource,
@@ -116,9 +65,7 @@ const struct wl_region_interface WaylandRegion::Impl::region_interface {
       return;
     }
 
-    auto rect = std::make_unique<RectArea>(x, y, width, height);
-    impl->data = std::make_unique<IntersectionArea>(
-        std::move(impl->data), std::make_unique<InverseArea>(std::move(rect)));
+    impl->region.Subtract(ClampClientRect(x, y, width, height));
   }
 };
 
@@ -131,4 +78,12 @@ WaylandRegion::WaylandRegion(wl_client* client, uint32_t id, uint version) {
   impl_ = impl;
 }
 
+Region WaylandRegion::GetRegionFrom(WaylandResource resource) {
+  auto impl = resource.Get<Impl>();
+  if (!impl) {
+    return Region();
+  }
+  return impl->region;
+}
+
 }  // namespace waffle
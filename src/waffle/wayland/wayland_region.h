@@ -9,12 +9,18 @@
 
 #include <memory>
 
+#include "waffle/utils/region.h"
+#include "waffle/wayland/wayland_resource.h"
+
 namespace waffle {
 
 class WaylandRegion {
  public:
   WaylandRegion(wl_client* client, uint32_t id, uint version);
 
+  // Returns the area of the wl_region |resource|.
+  static Region GetRegionFrom(WaylandResource resource);
+
  private:
   struct Impl;
   std::weak_ptr<Impl> impl_;
@@ -0,0 +1,118 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "waffle/wayland/wayland_relative_pointer.h"
+
+#include <wayland/protocols/relative-pointer-unstable-v1-server-protocol.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "waffle/logger.h"
+
+namespace waffle {
+
+struct WaylandRelativePointerManager::Impl : WaylandResource::Data {
+  WaylandResource resource;
+
+  // Relative pointers of each client. Destroyed ones are pruned lazily.
+  static std::unordered_map<wl_client*, std::vector<WaylandResource>> umap;
+
+  static const struct zwp_relative_pointer_manager_v1_interface
+      kRelativePointerManagerInterface;
+  static const struct zwp_relative_pointer_v1_interface
+      kRelativePointerInterface;
+
+  static std::vector<WaylandResource>* GetRelativePointers(wl_client* client) {
+    auto iter = umap.find(client);
+    if (iter == umap.end()) {
+      return nullptr;
+    }
+
+    auto& pointers = iter->second;
+    pointers.erase(std::remove_if(pointers.begin(), pointers.end(),
+                                  [](WaylandResource& pointer) {
+                                    return !pointer.IsValid();
+                                  }),
+                   pointers.end());
+    if (pointers.empty()) {
+      umap.erase(iter);
+      return nullptr;
+    }
+    return &pointers;
+  }
+};
+
+std::unordered_map<wl_client*, std::vector<WaylandResource>>
+    WaylandRelativePointerManager::Impl::umap;
+
+const struct zwp_relative_pointer_v1_interface
+    WaylandRelativePointerManager::Impl::kRelativePointerInterface {
+  .destroy = +[](wl_client* client, wl_resource* resource) {
+    WAFFLE_LOG(TRACE) << "zwp_relative_pointer_v1_interface.destroy is called.";
+    WaylandResource(resource).Destroy();
+  },
+};
+
+const struct zwp_relative_pointer_manager_v1_interface
+    WaylandRelativePointerManager::Impl::kRelativePointerManagerInterface {
+  .destroy =
+      +[](wl_client* client, wl_resource* resource) {
+        WAFFLE_LOG(TRACE) << "zwp_relative_pointer_manager_v1_interface."
+                             "destroy is called.";
+        WaylandResource(resource).Destroy();
+      },
+  .get_relative_pointer = +[](wl_client* client,
+                              wl_resource* resource,
+                              uint32_t id,
+                              wl_resource* pointer) {
+    WAFFLE_LOG(TRACE) << "zwp_relative_pointer_manager_v1_interface."
+                         "get_relative_pointer is called.";
+
+    WaylandResource relative_pointer;
+    relative_pointer.Create(nullptr, client, id,
+                            &zwp_relative_pointer_v1_interface,
+                            wl_resource_get_version(resource),
+                            &kRelativePointerInterface);
+    umap[client].push_back(relative_pointer);
+  },
+};
+
+WaylandRelativePointerManager::WaylandRelativePointerManager(wl_client* client,
+                                                             uint32_t id,
+                                                             int32_t version) {
+  WAFFLE_LOG(TRACE) << "Creating WaylandRelativePointerManager...";
+
+  auto impl = std::make_shared<Impl>();
+  impl->resource.Create(impl, client, id,
+                        &zwp_relative_pointer_manager_v1_interface, version,
+                        &Impl::kRelativePointerManagerInterface);
+  impl_ = impl;
+}
+
+bool WaylandRelativePointerManager::HasRelativePointer(wl_client* client) {
+  return Impl::GetRelativePointers(client) != nullptr;
+}
+
+void WaylandRelativePointerManager::SendRelativeMotion(
+    wl_client* client,
+    uint64_t time_usec,
+    Vec2<double> delta,
+    Vec2<double> delta_unaccel) {
+  auto* pointers = Impl::GetRelativePointers(client);
+  if (!pointers) {
+    return;
+  }
+
+  for (auto& pointer : *pointers) {
+    zwp_relative_pointer_v1_send_relative_motion(
+        pointer.Resource(), time_usec >> 32, time_usec & 0xffffffff,
+        wl_fixed_from_double(delta.X()), wl_fixed_from_double(delta.Y()),
+        wl_fixed_from_double(delta_unaccel.X()),
+        wl_fixed_from_double(delta_unaccel.Y()));
+  }
+}
+
+}  // namespace waffle
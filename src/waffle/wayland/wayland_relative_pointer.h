@@ -0,0 +1,39 @@
+// Copyright 2022 Hidenori Matsubayashi All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WAFFLE_WAYLAND_WAYLAND_RELATIVE_POINTER_H_
+#define WAFFLE_WAYLAND_WAYLAND_RELATIVE_POINTER_H_
+
+#include "waffle/utils/vec2.h"
+#include "waffle/wayland/wayland_resource.h"
+
+namespace waffle {
+
+constexpr uint kZwpRelativePointerManagerV1MaxVersion = 1;
+
+class WaylandRelativePointerManager {
+ public:
+  WaylandRelativePointerManager(wl_client* client,
+                                uint32_t id,
+                                int32_t version);
+  ~WaylandRelativePointerManager() = default;
+
+  // Returns true if |client| has any zwp_relative_pointer_v1.
+  static bool HasRelativePointer(wl_client* client);
+
+  // Sends zwp_relative_pointer_v1.relative_motion to all relative pointers of
+  // |client|. |time_usec| is the timestamp of the input device.
+  static void SendRelativeMotion(wl_client* client,
+                                 uint64_t time_usec,
+                                 Vec2<double> delta,
+                                 Vec2<double> delta_unaccel);
+
+ private:
+  struct Impl;
+  std::weak_ptr<Impl> impl_;
+};
+
+}  // namespace waffle
+
+#endif  // WAFFLE_WAYLAND_WAYLAND_RELATIVE_POINTER_H_
@@ -4,9 +4,6 @@
 
 #include "waffle/wayland/wayland_seat.h"
 
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <unistd.h>
 #include <wayland/protocols/wayland-server-protocol.h>
 
 #include <cassert>
@@ -14,24 +11,80 @@
 #include <unordered_map>
 
 #include "waffle/logger.h"
+#include "waffle/wayland/wayland_keymap.h"
+#include "waffle/wayland/wayland_relative_pointer.h"
 #include "waffle/wayland_server.h"
 
 namespace waffle {
 
+namespace {
+// Key repeat is done by clients with these parameters.
+constexpr int32_t kKeyRepeatRate = 25;  // keys per second
+constexpr int32_t kKeyRepeatDelay = 600;  // ms
+
+// The keymap is shared by all seats, so it's compiled only once.
+WaylandKeymap& SharedKeymap() {
+  static WaylandKeymap keymap;
+  return keymap;
+}
+
+// Timestamps of the wl_pointer, wl_keyboard and wl_touch events are in
+// milliseconds, and they wrap around.
+uint32_t ToEventTime(uint64_t time_usec) {
+  return static_cast<uint32_t>(time_usec / 1000);
+}
+}  // namespace
+
 struct WlSeat::Impl : WaylandResource::Data {
   wl_resource* last_resource = nullptr;
   WaylandResource seat;
   WaylandResource pointer;
   WaylandResource keyboard;
+  WaylandResource touch;
+
+  // The modifiers which were sent to the client last.
+  WaylandKeymap::Modifiers sent_modifiers;
+
+  // The surface which the keyboard has entered, and the seat of its client.
+  // There is only one focus for all clients.
+  static WaylandResource keyboard_focus;
+  static std::weak_ptr<Impl> keyboard_focus_seat;
+
+  // Sends wl_keyboard.leave to the focused surface and clears the focus.
+  static void ClearKeyboardFocus() {
+    auto seat = keyboard_focus_seat.lock();
+    if (seat && seat->keyboard.IsValid() && keyboard_focus.IsValid()) {
+      wl_keyboard_send_leave(seat->keyboard.Resource(),
+                             WaylandServer::SerialNumber(),
+                             keyboard_focus.Resource());
+    }
+    keyboard_focus = WaylandResource();
+    keyboard_focus_seat.reset();
+  }
+
+  void SendModifiers() {
+    auto modifiers = SharedKeymap().GetModifiers();
+    if (modifiers == sent_modifiers) {
+      return;
+    }
+    sent_modifiers = modifiers;
+    wl_keyboard_send_modifiers(keyboard.Resource(),
+                               WaylandServer::SerialNumber(),
+                               modifiers.depressed, modifiers.latched,
+                               modifiers.locked, modifiers.group);
+  }
 
   static std::unordered_map<wl_client*, std::weak_ptr<Impl>> umap;
 
   static const struct wl_pointer_interface kWlPointerInterface;
   static const struct wl_keyboard_interface kWlKeyboardInterface;
+  static const struct wl_touch_interface kWlTouchInterface;
   static const struct wl_seat_interface kWlSeatInterface;
 };
 
 std::unordered_map<wl_client*, std::weak_ptr<WlSeat::Impl>> WlSeat::Impl::umap;
+WaylandResource WlSeat::Impl::keyboard_focus;
+std::weak_ptr<WlSeat::Impl> WlSeat::Impl::keyboard_focus_seat;
 
 const struct wl_pointer_interface WlSeat::Impl::kWlPointerInterface {
   .set_cursor =
@@ -57,6 +110,13 @@ const struct wl_keyboard_interface WlSeat::Impl::kWlKeyboardInterface {
   }
 };
 
+const struct wl_touch_interface WlSeat::Impl::kWlTouchInterface {
+  .release = +[](wl_client* client, wl_resource* resource) {
+    WAFFLE_LOG(TRACE) << "wl_touch_interface.release is called.";
+    WaylandResource(resource).Destroy();
+  }
+};
+
 const struct wl_seat_interface WlSeat::Impl::kWlSeatInterface {
   .get_pointer =
       +[](wl_client* client, wl_resource* resource, uint32_t id) {
@@ -85,7 +145,7 @@ const struct wl_seat_interface WlSeat::Impl::kWlSeatInterface {
           return;
         }
 
-        if (impl->pointer.IsValid()) {
+        if (impl->keyboard.IsValid()) {
           WAFFLE_LOG(WARNING) << "Resouce is already created.";
           return;
         }
@@ -94,12 +154,39 @@ const struct wl_seat_interface WlSeat::Impl::kWlSeatInterface {
                               wl_resource_get_version(resource),
                               &kWlKeyboardInterface);
         auto keyboard = impl->keyboard;
-        // TODO: implement here.
+
+        // Every client gets the same file, so nothing is copied per client.
+        auto& keymap = SharedKeymap();
+        if (keymap.IsValid()) {
+          wl_keyboard_send_keymap(keyboard.Resource(),
+                                  WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1,
+                                  keymap.Fd(), keymap.Size());
+        } else {
+          WAFFLE_LOG(ERROR) << "No keymap is available.";
+        }
+
+        if (keyboard.Version() >= WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION) {
+          wl_keyboard_send_repeat_info(keyboard.Resource(), kKeyRepeatRate,
+                                       kKeyRepeatDelay);
+        }
       },
   .get_touch =
       +[](wl_client* client, wl_resource* resource, uint32_t id) {
-        WAFFLE_LOG(WARNING)
-            << "wl_seat_interface.get_touch is called (not yet implemented)";
+        WAFFLE_LOG(TRACE) << "wl_seat_interface.get_touch is called.";
+        auto impl = WaylandResource(resource).Get<Impl>();
+        if (!impl) {
+          WAFFLE_LOG(WARNING) << "Resouce is invalid.";
+          return;
+        }
+
+        if (impl->touch.IsValid()) {
+          WAFFLE_LOG(WARNING) << "Resouce is already created.";
+          return;
+        }
+
+        impl->touch.Create(impl, client, id, &wl_touch_interface,
+                           wl_resource_get_version(resource),
+                           &kWlTouchInterface);
       },
   .release = +[](wl_client* client, wl_resource* resource) {
     WAFFLE_LOG(TRACE) << "wl_seat_interface.release is called.";
@@ -123,10 +210,13 @@ WlSeat::WlSeat(wl_client* client, uint32_t id, uint version) {
 
   wl_seat_send_capabilities(
       impl->seat.Resource(),
-      WL_SEAT_CAPABILITY_POINTER | WL_SEAT_CAPABILITY_KEYBOARD);
+      WL_SEAT_CAPABILITY_POINTER | WL_SEAT_CAPABILITY_KEYBOARD |
+          WL_SEAT_CAPABILITY_TOUCH);
 }
 
-void WlSeat::OnPointerMove(Vec2<double> pos, WaylandResource surface) {
+void WlSeat::OnPointerMove(uint64_t time_usec,
+                           Vec2<double> pos,
+                           WaylandResource surface) {
   auto impl = GetImplFromSurface(surface);
   if (!impl || impl->pointer.IsNull()) {
     WAFFLE_LOG(ERROR) << "Client has not created the needed objects";
@@ -143,12 +233,39 @@ void WlSeat::OnPointerMove(Vec2<double> pos, WaylandResource surface) {
     }
   } else {
     if (pointer.Version() >= WL_POINTER_MOTION_SINCE_VERSION) {
-      wl_pointer_send_motion(pointer.Resource(), 100 /*TODO*/,
+      wl_pointer_send_motion(pointer.Resource(), ToEventTime(time_usec),
                              wl_fixed_from_double(pos.X()),
                              wl_fixed_from_double(pos.Y()));
     }
   }
+}
+
+void WlSeat::OnPointerRelativeMotion(uint64_t time_usec,
+                                     Vec2<double> delta,
+                                     Vec2<double> delta_unaccel,
+                                     WaylandResource surface) {
+  auto impl = GetImplFromSurface(surface);
+  if (!impl || impl->pointer.IsNull()) {
+    return;
+  }
 
+  auto* client = wl_resource_get_client(surface.Resource());
+  if (!WaylandRelativePointerManager::HasRelativePointer(client)) {
+    return;
+  }
+
+  // Relative motion events belong to the wl_pointer frames.
+  WaylandRelativePointerManager::SendRelativeMotion(client, time_usec, delta,
+                                                    delta_unaccel);
+}
+
+void WlSeat::OnPointerFrame(WaylandResource surface) {
+  auto impl = GetImplFromSurface(surface);
+  if (!impl || impl->pointer.IsNull()) {
+    return;
+  }
+
+  auto pointer = impl->pointer;
   if (pointer.Version() >= WL_POINTER_FRAME_SINCE_VERSION) {
     wl_pointer_send_frame(pointer.Resource());
   }
@@ -173,7 +290,10 @@ void WlSeat::OnPointerLeave(WaylandResource surface) {
   }
 }
 
-void WlSeat::OnPointerClick(uint button, bool down, WaylandResource surface) {
+void WlSeat::OnPointerClick(uint64_t time_usec,
+                            uint button,
+                            bool down,
+                            WaylandResource surface) {
   auto impl = GetImplFromSurface(surface);
   if (!impl || impl->pointer.IsNull()) {
     WAFFLE_LOG(ERROR) << "Client has no target implementation.";
@@ -183,7 +303,7 @@ void WlSeat::OnPointerClick(uint button, bool down, WaylandResource surface) {
   auto pointer = impl->pointer;
   if (pointer.Version() >= WL_POINTER_BUTTON_SINCE_VERSION) {
     wl_pointer_send_button(pointer.Resource(), WaylandServer::SerialNumber(),
-                           100 /*TODO*/, button,
+                           ToEventTime(time_usec), button,
                            down ? WL_POINTER_BUTTON_STATE_PRESSED
                                 : WL_POINTER_BUTTON_STATE_RELEASED);
   }
@@ -193,14 +313,117 @@ void WlSeat::OnPointerClick(uint button, bool down, WaylandResource surface) {
   }
 }
 
-void WlSeat::OnKey(uint key, bool down, WaylandResource surface) {
+void WlSeat::OnKey(uint64_t time_usec,
+                   uint key,
+                   bool down,
+                   WaylandResource surface) {
   auto impl = GetImplFromSurface(surface);
   if (!impl || impl->keyboard.IsNull()) {
     WAFFLE_LOG(ERROR) << "Client has no target implementation.";
     return;
   }
 
-  // TODO: implement here.
+  auto keyboard = impl->keyboard;
+  auto& focus = Impl::keyboard_focus;
+  if (!focus.IsValid() || focus.Resource() != surface.Resource()) {
+    // The previous surface may belong to another client.
+    Impl::ClearKeyboardFocus();
+    focus = surface;
+    Impl::keyboard_focus_seat = impl;
+
+    // No keys are reported as pressed on enter. The one being pressed now
+    // follows as a key event.
+    wl_array keys;
+    wl_array_init(&keys);
+    wl_keyboard_send_enter(keyboard.Resource(), WaylandServer::SerialNumber(),
+                           surface.Resource(), &keys);
+    wl_array_release(&keys);
+
+    // Modifiers must always follow enter.
+    auto modifiers = SharedKeymap().GetModifiers();
+    impl->sent_modifiers = modifiers;
+    wl_keyboard_send_modifiers(keyboard.Resource(),
+                               WaylandServer::SerialNumber(),
+                               modifiers.depressed, modifiers.latched,
+                               modifiers.locked, modifiers.group);
+  }
+
+  wl_keyboard_send_key(keyboard.Resource(), WaylandServer::SerialNumber(),
+                       ToEventTime(time_usec), key,
+                       down ? WL_KEYBOARD_KEY_STATE_PRESSED
+                            : WL_KEYBOARD_KEY_STATE_RELEASED);
+  impl->SendModifiers();
+}
+
+void WlSeat::OnKeyboardLeave(WaylandResource surface) {
+  if (Impl::keyboard_focus.Resource() != surface.Resource()) {
+    return;
+  }
+  Impl::ClearKeyboardFocus();
+}
+
+void WlSeat::UpdateKeyboardState(uint32_t key, bool down) {
+  SharedKeymap().UpdateKey(key, down);
+}
+
+void WlSeat::OnTouchDown(uint64_t time_usec,
+                         int32_t id,
+                         Vec2<double> pos,
+                         WaylandResource surface) {
+  auto impl = GetImplFromSurface(surface);
+  if (!impl || impl->touch.IsNull()) {
+    WAFFLE_LOG(TRACE) << "Client has not created the needed objects";
+    return;
+  }
+
+  auto touch = impl->touch;
+  wl_touch_send_down(touch.Resource(), WaylandServer::SerialNumber(),
+                     ToEventTime(time_usec), surface.Resource(), id,
+                     wl_fixed_from_double(pos.X()),
+                     wl_fixed_from_double(pos.Y()));
+  wl_touch_send_frame(touch.Resource());
+}
+
+void WlSeat::OnTouchUp(uint64_t time_usec,
+                       int32_t id,
+                       WaylandResource surface) {
+  auto impl = GetImplFromSurface(surface);
+  if (!impl || impl->touch.IsNull()) {
+    WAFFLE_LOG(TRACE) << "Client has not created the needed objects";
+    return;
+  }
+
+  auto touch = impl->touch;
+  wl_touch_send_up(touch.Resource(), WaylandServer::SerialNumber(),
+                   ToEventTime(time_usec), id);
+  wl_touch_send_frame(touch.Resource());
+}
+
+void WlSeat::OnTouchMotion(uint64_t time_usec,
+                           int32_t id,
+                           Vec2<double> pos,
+                           WaylandResource surface) {
+  auto impl = GetImplFromSurface(surface);
+  if (!impl || impl->touch.IsNull()) {
+    WAFFLE_LOG(TRACE) << "Client has not created the needed objects";
+    return;
+  }
+
+  auto touch = impl->touch;
+  wl_touch_send_motion(touch.Resource(), ToEventTime(time_usec), id,
+                       wl_fixed_from_double(pos.X()),
+                       wl_fixed_from_double(pos.Y()));
+  wl_touch_send_frame(touch.Resource());
+}
+
+void WlSeat::OnTouchCancel(WaylandResource surface) {
+  auto impl = GetImplFromSurface(surface);
+  if (!impl || impl->touch.IsNull()) {
+    WAFFLE_LOG(TRACE) << "Client has not created the needed objects";
+    return;
+  }
+
+  wl_touch_send_cancel(impl->touch.Resource());
 }
 
 WlSeat WlSeat::GetFromClient(wl_client* client) {
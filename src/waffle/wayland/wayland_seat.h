@@ -22,15 +22,63 @@ class WlSeat {
   WlSeat(wl_client* client, uint32_t id, uint version);
   ~WlSeat() = default;
 
-  static void OnPointerMove(Vec2<double> pos, WaylandResource surface);
+  // |time_usec| of the input events is the timestamp of the input device in
+  // microseconds of CLOCK_MONOTONIC. It's sent to clients in milliseconds.
+  // The motion is followed by OnPointerFrame().
+  static void OnPointerMove(uint64_t time_usec,
+                            Vec2<double> pos,
+                            WaylandResource surface);
+
+  // Sends a raw motion sample to the relative pointers of the client of
+  // |surface|, if any.
+  static void OnPointerRelativeMotion(uint64_t time_usec,
+                                      Vec2<double> delta,
+                                      Vec2<double> delta_unaccel,
+                                      WaylandResource surface);
+
+  // Sends wl_pointer.frame after OnPointerMove() and
+  // OnPointerRelativeMotion().
+  static void OnPointerFrame(WaylandResource surface);
 
   static void OnPointerLeave(WaylandResource surface);
 
-  static void OnPointerClick(uint32_t button,
+  static void OnPointerClick(uint64_t time_usec,
+                             uint32_t button,
                              bool down,
                              WaylandResource surface);
 
-  static void OnKey(uint32_t key, bool down, WaylandResource surface);
+  // Sends the key to the client of |surface|. The keyboard enters |surface|
+  // first if it's not focused yet, leaving the previously focused surface of
+  // any client. Modifiers follow the key when they have changed since they
+  // were last sent to the client.
+  static void OnKey(uint64_t time_usec,
+                    uint32_t key,
+                    bool down,
+                    WaylandResource surface);
+
+  // Sends wl_keyboard.leave if |surface| has the keyboard focus.
+  static void OnKeyboardLeave(WaylandResource surface);
+
+  // Updates the seat-wide keyboard state. This must be called for every key
+  // even if no surface has the keyboard focus, so that modifiers don't get
+  // stuck.
+  static void UpdateKeyboardState(uint32_t key, bool down);
+
+  static void OnTouchDown(uint64_t time_usec,
+                          int32_t id,
+                          Vec2<double> pos,
+                          WaylandResource surface);
+
+  static void OnTouchUp(uint64_t time_usec,
+                        int32_t id,
+                        WaylandResource surface);
+
+  static void OnTouchMotion(uint64_t time_usec,
+                            int32_t id,
+                            Vec2<double> pos,
+                            WaylandResource surface);
+
+  static void OnTouchCancel(WaylandResource surface);
 
  private:
   struct Impl;
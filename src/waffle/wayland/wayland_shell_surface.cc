@@ -21,6 +21,13 @@ struct WaylandShellSurface::Impl : WaylandResource::Data,
   WaylandSurface wayland_surface;
   WaylandResource resource;
 
+  SceneNode scene_node{SceneNode::Type::kToplevel, this};
+
+  ~Impl() {
+    waffle::Compositor::Instance()->RemoveWindow(&scene_node);
+    wayland_surface.SetMapped(false);
+  }
+
   static const struct wl_shell_surface_interface wl_shell_surface_interface;
 
   // |WaylandBindingHandler|
@@ -32,6 +39,31 @@ struct WaylandShellSurface::Impl : WaylandResource::Data,
   std::weak_ptr<WaylandBindingHandlerDelegate> InputInterface() {
     return wayland_surface.InputInterface();
   }
+
+  // |WaylandBindingHandler|
+  Region TakeDamage() { return wayland_surface.TakeDamage(); }
+
+  // |WaylandBindingHandler|
+  Texture GetTexture() { return wayland_surface.GetTexture(); }
+
+  // |WaylandBindingHandler|
+  const DmabufAttributes* GetDmabufAttributes() {
+    return wayland_surface.GetDmabufAttributes();
+  }
+
+  // |WaylandBindingHandler|
+  wl_resource* GetDmabufBuffer() { return wayland_surface.GetDmabufBuffer(); }
+
+  // |WaylandBindingHandler|
+  Region OpaqueRegion() { return wayland_surface.OpaqueRegion(); }
+
+  // |WaylandBindingHandler|
+  bool AcceptsInput(Vec2<double> pos) {
+    return wayland_surface.AcceptsInput(pos);
+  }
+
+  // |WaylandBindingHandler|
+  void SetVisible(bool visible) { wayland_surface.SetVisible(visible); }
 };
 
 const struct wl_shell_surface_interface
@@ -118,11 +150,11 @@ WaylandShellSurface::WaylandShellSurface(wl_client* client,
   WAFFLE_LOG(TRACE) << "Creating WaylandShellSurface ...";
 
   auto impl = std::make_shared<Impl>();
-  waffle::Compositor::Instance()->AddWindow(impl);
+  waffle::Compositor::Instance()->AddWindow(&impl->scene_node);
 
   impl->wayland_surface = surface;
+  impl->wayland_surface.SetMapped(true);
   impl->client = client;
-  impl->SetTexture(surface.GetTexture());
   impl->resource.Create(impl, client, id, &wl_shell_surface_interface, version,
                         &Impl::wl_shell_surface_interface);
   impl_ = impl;
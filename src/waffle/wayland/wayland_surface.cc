@@ -6,45 +6,198 @@
 
 #include <wayland/protocols/wayland-server-protocol.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "waffle/compositor/compositor.h"
 #include "waffle/logger.h"
-#include "waffle/renderer/window_renderer.h"
+#include "waffle/utils/rect.h"
 #include "waffle/utils/vec2.h"
 #include "waffle/wayland/wayland_binding_handler_delegate.h"
+#include "waffle/wayland/wayland_linux_dmabuf.h"
+#include "waffle/wayland/wayland_presentation.h"
+#include "waffle/wayland/wayland_region.h"
 #include "waffle/wayland/wayland_resource.h"
 #include "waffle/wayland/wayland_seat.h"
 
 namespace waffle {
 
+namespace {
+
+// Keeps a client buffer which the compositor samples or scans out directly.
+// The client must not reuse the buffer until it is released, so it's held
+// until a frame without it is presented.
+struct HeldBuffer {
+  wl_resource* buffer = nullptr;
+  wl_listener destroy_listener;
+
+  HeldBuffer() = default;
+  HeldBuffer(const HeldBuffer&) = delete;
+  HeldBuffer& operator=(const HeldBuffer&) = delete;
+  ~HeldBuffer() { Release(); }
+
+  void Hold(wl_resource* new_buffer) {
+    Release();
+    buffer = new_buffer;
+    destroy_listener.notify = +[](wl_listener* listener, void* data) {
+      HeldBuffer* held = wl_container_of(listener, held, destroy_listener);
+      wl_list_remove(&held->destroy_listener.link);
+      held->buffer = nullptr;
+    };
+    wl_resource_add_destroy_listener(buffer, &destroy_listener);
+  }
+
+  void Release() {
+    if (!buffer) {
+      return;
+    }
+    wl_list_remove(&destroy_listener.link);
+    wl_buffer_send_release(buffer);
+    buffer = nullptr;
+  }
+};
+
+}  // namespace
+
 struct WaylandSurface::Impl : WaylandResource::Data,
                               WaylandBindingHandlerDelegate {
   wl_resource* wl_resource_buffer = nullptr;
+  // |texture| is the texture of the current buffer. It refers to either
+  // |shm_texture| or the texture cached for a client's EGL buffer.
   Texture texture;
+  Texture shm_texture;
+  bool shm_texture_attached = false;
+  std::unique_ptr<HeldBuffer> held_buffer;
   WaylandResource resource_surface;
-  WindowRenderer renderer;
   Vec2<int> size;
-  bool is_damaged = false;
+  // Damaged area in surface local coordinates. |pending_damage| is
+  // accumulated by wl_surface.damage and applied to |damage| on commit. The
+  // compositor takes |damage| when it draws the next frame.
+  Region pending_damage;
+  Region damage;
+  // Damaged area in buffer coordinates accumulated by wl_surface.damage_buffer.
+  // Only this area of the attached shm buffer is uploaded on commit.
+  Region pending_buffer_damage;
+  // wl_surface.frame callbacks and wp_presentation feedbacks requested for
+  // the next content update. They take effect on commit.
+  std::vector<WaylandResource> pending_callbacks;
+  std::vector<WaylandResource> pending_feedbacks;
+  // Committed wl_surface.frame callbacks waiting for the next frame.
+  std::vector<WaylandResource> callbacks;
+  // Whether the buffer format has no alpha channel.
+  bool opaque = false;
+  // Opaque area hinted by the client, in surface local coordinates.
+  // |pending_opaque_region| is applied to |opaque_region| on commit.
+  Region pending_opaque_region;
+  Region opaque_region;
+  // Area which accepts pointer and touch input, in surface local coordinates.
+  // The whole surface accepts input unless |input_region_set| is true.
+  Region pending_input_region;
+  bool pending_input_region_set = false;
+  Region input_region;
+  bool input_region_set = false;
+  // Whether the surface is in the scene, and whether any part of it was shown
+  // in the last frame. Callbacks of mapped surfaces which are hidden are
+  // throttled.
+  bool mapped = false;
+  bool visible = false;
+  FrameClock::Clock::time_point last_callback_time;
 
   static const struct wl_surface_interface kWlSurfaceInterface;
-  static std::vector<WaylandResource> callbacks;
+  // All surfaces which are alive.
+  static std::vector<Impl*> surfaces;
+  // Feedbacks of committed content updates which are not drawn yet. A newer
+  // commit of the same surface supersedes them.
+  static std::vector<std::pair<WaylandResource, Impl*>> committed_feedbacks;
+  // Feedbacks of the content updates in the frame waiting for presentation.
+  static std::vector<WaylandResource> latched_feedbacks;
+  // Buffers which were replaced by newer ones, and the number of the first
+  // frame which doesn't show them. They are still on the screen until that
+  // frame is presented.
+  static std::vector<std::pair<std::unique_ptr<HeldBuffer>, uint64_t>>
+      retired_buffers;
+  // The number of the frames submitted so far.
+  static uint64_t submitted_frames;
+
+  void RetireHeldBuffer() {
+    if (held_buffer) {
+      retired_buffers.emplace_back(std::move(held_buffer),
+                                   submitted_frames + 1);
+    }
+  }
+
+  Impl() { surfaces.push_back(this); }
+
+  bool IsThrottled() const { return mapped && !visible; }
+
+  ~Impl() {
+    surfaces.erase(std::remove(surfaces.begin(), surfaces.end(), this),
+                   surfaces.end());
+    RetireHeldBuffer();
+    for (auto feedback : pending_feedbacks) {
+      WaylandPresentation::SendDiscarded(feedback);
+    }
+    DiscardCommittedFeedbacks();
+  }
+
+  void SendFrameCallbacks(FrameClock::Clock::time_point now) {
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    now.time_since_epoch())
+                    .count();
+    for (auto resource : callbacks) {
+      if (resource.IsValid()) {
+        if (resource.Version() >= WL_CALLBACK_DONE_SINCE_VERSION) {
+          wl_callback_send_done(resource.Resource(), time);
+        }
+        resource.Destroy();
+      }
+    }
+    callbacks.clear();
+    last_callback_time = now;
+  }
 
-  void OnPointerMove(Vec2<double> pos) {
+  void DiscardCommittedFeedbacks() {
+    auto it = std::remove_if(
+        committed_feedbacks.begin(), committed_feedbacks.end(),
+        [this](const std::pair<WaylandResource, Impl*>& committed) {
+          return committed.second == this;
+        });
+    for (auto discarded = it; discarded != committed_feedbacks.end();
+         ++discarded) {
+      WaylandPresentation::SendDiscarded(discarded->first);
+    }
+    committed_feedbacks.erase(it, committed_feedbacks.end());
+  }
+
+  void OnPointerMove(uint64_t time_usec, Vec2<double> pos) {
+    if (!resource_surface.IsValid()) {
+      return;
+    }
+
+    WlSeat::OnPointerMove(time_usec, pos, resource_surface);
+  }
+
+  void OnPointerRelativeMotion(uint64_t time_usec,
+                               Vec2<double> delta,
+                               Vec2<double> delta_unaccel) {
     if (!resource_surface.IsValid()) {
       return;
     }
+    WlSeat::OnPointerRelativeMotion(time_usec, delta, delta_unaccel,
+                                    resource_surface);
+  }
 
-    // todo: compositor window size.
-    constexpr double kHeight = 1024;
-    auto surface_pos = Vec2<double>(pos.X(), pos.Y() - (kHeight - size.Y()));
-    if (surface_pos.Y() < 0) {
+  void OnPointerFrame() {
+    if (!resource_surface.IsValid()) {
       return;
     }
-    WlSeat::OnPointerMove(surface_pos, resource_surface);
+    WlSeat::OnPointerFrame(resource_surface);
   }
 
   void OnPointerLeave() {
@@ -54,22 +207,63 @@ struct WaylandSurface::Impl : WaylandResource::Data,
     WlSeat::OnPointerLeave(resource_surface);
   }
 
-  void OnPointerClick(uint button, bool down) {
+  void OnPointerClick(uint64_t time_usec, uint button, bool down) {
+    if (!resource_surface.IsValid()) {
+      return;
+    }
+    WlSeat::OnPointerClick(time_usec, button, down, resource_surface);
+  }
+
+  void OnKey(uint64_t time_usec, uint key, bool down) {
+    if (!resource_surface.IsValid()) {
+      return;
+    }
+    WlSeat::OnKey(time_usec, key, down, resource_surface);
+  }
+
+  void OnKeyboardLeave() {
+    if (!resource_surface.IsValid()) {
+      return;
+    }
+    WlSeat::OnKeyboardLeave(resource_surface);
+  }
+
+  void OnTouchDown(uint64_t time_usec, int32_t id, Vec2<double> pos) {
+    if (!resource_surface.IsValid()) {
+      return;
+    }
+    WlSeat::OnTouchDown(time_usec, id, pos, resource_surface);
+  }
+
+  void OnTouchUp(uint64_t time_usec, int32_t id) {
+    if (!resource_surface.IsValid()) {
+      return;
+    }
+    WlSeat::OnTouchUp(time_usec, id, resource_surface);
+  }
+
+  void OnTouchMotion(uint64_t time_usec, int32_t id, Vec2<double> pos) {
     if (!resource_surface.IsValid()) {
       return;
     }
-    WlSeat::OnPointerClick(button, down, resource_surface);
+    WlSeat::OnTouchMotion(time_usec, id, pos, resource_surface);
   }
 
-  void OnKey(uint key, bool down) {
+  void OnTouchCancel() {
     if (!resource_surface.IsValid()) {
       return;
     }
-    WlSeat::OnKey(key, down, resource_surface);
+    WlSeat::OnTouchCancel(resource_surface);
   }
 };
 
-std::vector<WaylandResource> WaylandSurface::Impl::callbacks;
+std::vector<WaylandSurface::Impl*> WaylandSurface::Impl::surfaces;
+std::vector<std::pair<WaylandResource, WaylandSurface::Impl*>>
+    WaylandSurface::Impl::committed_feedbacks;
+std::vector<WaylandResource> WaylandSurface::Impl::latched_feedbacks;
+std::vector<std::pair<std::unique_ptr<HeldBuffer>, uint64_t>>
+    WaylandSurface::Impl::retired_buffers;
+uint64_t WaylandSurface::Impl::submitted_frames = 0;
 
 const struct wl_surface_interface WaylandSurface::Impl::kWlSurfaceInterface {
   .destroy =
@@ -106,26 +300,58 @@ const struct wl_surface_interface WaylandSurface::Impl::kWlSurfaceInterface {
           WAFFLE_LOG(INFO) << "Resource is invalid.";
           return;
         }
-        impl->is_damaged = true;
+        // Damage outside the surface is ignored. A resize damages the whole
+        // surface on commit anyway.
+        impl->pending_damage.Union(
+            ClampClientRect(x, y, width, height, impl->size));
       },
   .frame =
       +[](wl_client* client, wl_resource* resource, uint32_t callback) {
         WAFFLE_LOG(TRACE) << "wl_surface_interface.frame called.";
 
+        auto impl = WaylandResource(resource).Get<Impl>();
+        if (!impl) {
+          WAFFLE_LOG(INFO) << "Resource is invalid.";
+          return;
+        }
+
         WaylandResource resource_callback;
         resource_callback.Create(nullptr, client, callback,
                                  &wl_callback_interface, 1, nullptr);
-        callbacks.push_back(resource_callback);
+        impl->pending_callbacks.push_back(resource_callback);
       },
   .set_opaque_region =
       +[](wl_client* client, wl_resource* resource, wl_resource* region) {
         WAFFLE_LOG(TRACE) << "wl_surface_interface.set_opaque_region is "
-                             "called (not yet implemented)";
+                             "called.";
+
+        auto impl = WaylandResource(resource).Get<Impl>();
+        if (!impl) {
+          WAFFLE_LOG(INFO) << "Resource is invalid.";
+          return;
+        }
+
+        // NULL means that the whole surface may be translucent.
+        impl->pending_opaque_region =
+            region ? WaylandRegion::GetRegionFrom(WaylandResource(region))
+                   : Region();
       },
   .set_input_region =
       +[](wl_client* client, wl_resource* resource, wl_resource* region) {
-        WAFFLE_LOG(WARNING) << "wl_surface_interface.set_input_region is "
-                               "called (not yet implemented)";
+        WAFFLE_LOG(TRACE) << "wl_surface_interface.set_input_region is "
+                             "called.";
+
+        auto impl = WaylandResource(resource).Get<Impl>();
+        if (!impl) {
+          WAFFLE_LOG(INFO) << "Resource is invalid.";
+          return;
+        }
+
+        // NULL means that the whole surface accepts input.
+        impl->pending_input_region_set = region != nullptr;
+        impl->pending_input_region =
+            region ? WaylandRegion::GetRegionFrom(WaylandResource(region))
+                   : Region();
       },
   .commit =
       +[](wl_client* client, wl_resource* resource) {
@@ -137,9 +363,15 @@ const struct wl_surface_interface WaylandSurface::Impl::kWlSurfaceInterface {
           return;
         }
 
+        // Buffer transforms and scales are not supported yet, so the surface
+        // coordinates are identical to the buffer coordinates.
+        auto buffer_damage = impl->pending_buffer_damage;
+        buffer_damage.Union(impl->pending_damage);
+        impl->pending_damage.Union(impl->pending_buffer_damage);
+        impl->pending_buffer_damage.Clear();
+
         auto* buffer = impl->wl_resource_buffer;
-        if (buffer != nullptr && impl->is_damaged) {
-          // TODO: Repaint damaged region only.
+        if (buffer != nullptr) {
           uint32_t width = 0;
           uint32_t height = 0;
           auto* shm_buffer = wl_shm_buffer_get(buffer);
@@ -147,31 +379,110 @@ const struct wl_surface_interface WaylandSurface::Impl::kWlSurfaceInterface {
           if (shm_buffer) {
             width = wl_shm_buffer_get_width(shm_buffer);
             height = wl_shm_buffer_get_height(shm_buffer);
-            auto* data = wl_shm_buffer_get_data(shm_buffer);
+            auto stride = wl_shm_buffer_get_stride(shm_buffer);
             auto format = wl_shm_buffer_get_format(shm_buffer);
 
-            // TODO: Support target shm buffer format.
+            auto texture_format = TextureFormat::kUnknown;
             switch (format) {
               case WL_SHM_FORMAT_ARGB8888:
                 WAFFLE_LOG(TRACE) << "shm buffer format: ARGB8888";
+                texture_format = TextureFormat::kARGB8888;
                 break;
               case WL_SHM_FORMAT_XRGB8888:
                 WAFFLE_LOG(TRACE) << "shm buffer format: XRGB8888";
+                texture_format = TextureFormat::kXRGB8888;
+                break;
+              case WL_SHM_FORMAT_NV12:
+                WAFFLE_LOG(TRACE) << "shm buffer format: NV12";
+                texture_format = TextureFormat::kNV12;
+                break;
+              case WL_SHM_FORMAT_YUV420:
+                WAFFLE_LOG(TRACE) << "shm buffer format: YUV420";
+                texture_format = TextureFormat::kI420;
+                break;
+              case WL_SHM_FORMAT_YUYV:
+                WAFFLE_LOG(TRACE) << "shm buffer format: YUYV";
+                texture_format = TextureFormat::kYUYV;
                 break;
               default:
-                WAFFLE_LOG(TRACE) << "shm buffer format: " << format;
+                // Only the formats above are advertised.
+                WAFFLE_LOG(WARNING) << "Unsupported shm buffer format: "
+                                    << format;
                 break;
             }
-            impl->texture.LoadBufferImage(data, width, height);
+
+            // |shm_texture| is outdated if EGL buffers were attached in the
+            // meantime.
+            if (!impl->shm_texture_attached) {
+              buffer_damage.Union(Rect<int>(0, 0, width, height));
+            }
+
+            wl_shm_buffer_begin_access(shm_buffer);
+            auto* data = wl_shm_buffer_get_data(shm_buffer);
+            impl->shm_texture.LoadBufferImage(data, width, height, stride,
+                                              texture_format, buffer_damage);
+            wl_shm_buffer_end_access(shm_buffer);
+            impl->texture = impl->shm_texture;
+            impl->shm_texture_attached = true;
+            impl->opaque = format != WL_SHM_FORMAT_ARGB8888;
+
+            // The pixels have been copied, so the buffer can be reused by the
+            // client right away.
+            wl_buffer_send_release(buffer);
+            impl->RetireHeldBuffer();
           } else {
             auto* compositor = waffle::Compositor::Instance();
-            compositor->LoadIntoTexture(buffer, impl->texture);
+            auto* attributes = WaylandLinuxDmabuf::GetAttributes(buffer);
+            if (attributes) {
+              compositor->LoadDmabufIntoTexture(buffer, *attributes,
+                                                impl->texture);
+            } else {
+              compositor->LoadIntoTexture(buffer, impl->texture);
+            }
+            impl->shm_texture_attached = false;
+            // The opacity of client buffers is unknown here. Dmabuf buffers
+            // are judged by their formats. See GetDmabufAttributes().
+            impl->opaque = false;
+
+            // The texture refers to the buffer itself. A client may commit
+            // the same buffer again, e.g. with new damage, and then it stays
+            // on the screen under the existing hold.
+            if (!impl->held_buffer || impl->held_buffer->buffer != buffer) {
+              impl->RetireHeldBuffer();
+              impl->held_buffer = std::make_unique<HeldBuffer>();
+              impl->held_buffer->Hold(buffer);
+            }
           }
-
-          wl_buffer_send_release(buffer);
           impl->wl_resource_buffer = nullptr;
-          impl->size = Vec2<int>(width, height);
+
+          // The whole surface needs to be repainted when its size changed.
+          auto size = impl->texture.Size();
+          if (size.X() != impl->size.X() || size.Y() != impl->size.Y()) {
+            impl->pending_damage.Union(Rect<int>(
+                0, 0, std::max(size.X(), impl->size.X()),
+                std::max(size.Y(), impl->size.Y())));
+          }
+          impl->size = size;
         }
+
+        impl->damage.Union(impl->pending_damage);
+        impl->pending_damage.Clear();
+        impl->opaque_region = impl->pending_opaque_region;
+        impl->input_region = impl->pending_input_region;
+        impl->input_region_set = impl->pending_input_region_set;
+
+        impl->callbacks.insert(impl->callbacks.end(),
+                               impl->pending_callbacks.begin(),
+                               impl->pending_callbacks.end());
+        impl->pending_callbacks.clear();
+
+        impl->DiscardCommittedFeedbacks();
+        for (auto feedback : impl->pending_feedbacks) {
+          committed_feedbacks.emplace_back(feedback, impl.get());
+        }
+        impl->pending_feedbacks.clear();
+
+        waffle::Compositor::Instance()->ScheduleRepaint();
       },
   .set_buffer_transform =
       +[](wl_client* client, wl_resource* resource, int32_t transform) {
@@ -192,8 +503,15 @@ const struct wl_surface_interface WaylandSurface::Impl::kWlSurfaceInterface {
                        int32_t y,
                        int32_t width,
                        int32_t height) {
-    WAFFLE_LOG(ERROR) << "wl_surface_interface::damage_buffer called "
-                         "(not yet implemented)";
+    WAFFLE_LOG(TRACE) << "wl_surface_interface::damage_buffer called.";
+
+    auto impl = WaylandResource(resource).Get<Impl>();
+    if (!impl) {
+      WAFFLE_LOG(INFO) << "Resource is invalid.";
+      return;
+    }
+    impl->pending_buffer_damage.Union(
+        ClampClientRect(x, y, width, height, impl->size));
   },
 };
 
@@ -216,31 +534,83 @@ WaylandSurface WaylandSurface::GetSurfaceFrom(WaylandResource resource) {
   return result;
 }
 
-std::chrono::high_resolution_clock::time_point
-    WaylandSurface::program_start_time_ =
-        std::chrono::high_resolution_clock::now();
-
-int WaylandSurface::TimeSinceProgramStartMillisecond() {
-  auto usec =
-      (std::chrono::duration_cast<std::chrono::duration<double>>(
-           std::chrono::high_resolution_clock::now() - program_start_time_))
-          .count();
-  return usec * 1000;
+void WaylandSurface::HandleFrameCallbacks(FrameClock::Clock::time_point now) {
+  for (auto* surface : Impl::surfaces) {
+    if (!surface->IsThrottled()) {
+      surface->SendFrameCallbacks(now);
+    }
+  }
 }
 
-void WaylandSurface::HandleFrameCallbacks() {
-  // TODO: Don't call the callbacks if their windows are hidden.
-  for (auto resource : Impl::callbacks) {
-    if (resource.IsValid()) {
-      if (resource.Version() >= WL_CALLBACK_DONE_SINCE_VERSION) {
-        wl_callback_send_done(resource.Resource(),
-                              TimeSinceProgramStartMillisecond());
-      }
-      resource.Destroy();
+FrameClock::Clock::time_point WaylandSurface::HandleHiddenFrameCallbacks(
+    FrameClock::Clock::time_point now,
+    std::chrono::nanoseconds interval) {
+  auto next_time = FrameClock::Clock::time_point::max();
+  if (interval.count() <= 0) {
+    // Withheld until the surfaces become visible.
+    return next_time;
+  }
+
+  for (auto* surface : Impl::surfaces) {
+    if (!surface->IsThrottled() || surface->callbacks.empty()) {
+      continue;
+    }
+    auto time = surface->last_callback_time + interval;
+    if (time <= now) {
+      surface->SendFrameCallbacks(now);
+    } else {
+      next_time = std::min(next_time, time);
     }
   }
+  return next_time;
+}
+
+void WaylandSurface::SetMapped(bool mapped) {
+  std::shared_ptr<Impl> impl = impl_.lock();
+  if (!impl) {
+    return;
+  }
+  impl->mapped = mapped;
+  if (!mapped) {
+    impl->visible = false;
+  }
+}
 
-  Impl::callbacks.clear();
+void WaylandSurface::SetVisible(bool visible) {
+  std::shared_ptr<Impl> impl = impl_.lock();
+  if (!impl) {
+    return;
+  }
+  impl->visible = visible;
+}
+
+bool WaylandSurface::AcceptsInput(Vec2<double> pos) {
+  std::shared_ptr<Impl> impl = impl_.lock();
+  if (!impl) {
+    return false;
+  }
+
+  auto x = static_cast<int>(std::floor(pos.X()));
+  auto y = static_cast<int>(std::floor(pos.Y()));
+  if (!Rect<int>(0, 0, impl->size.X(), impl->size.Y()).Contains(x, y)) {
+    return false;
+  }
+  return !impl->input_region_set || impl->input_region.Contains(x, y);
+}
+
+Region WaylandSurface::OpaqueRegion() {
+  std::shared_ptr<Impl> impl = impl_.lock();
+  if (!impl) {
+    return Region();
+  }
+
+  auto surface_rect = Rect<int>(0, 0, impl->size.X(), impl->size.Y());
+  if (impl->opaque) {
+    return Region(surface_rect);
+  }
+  auto region = impl->opaque_region;
+  region.Intersect(surface_rect);
+  return region;
 }
 
 Texture WaylandSurface::GetTexture() {
@@ -256,6 +626,80 @@ Texture WaylandSurface::GetTexture() {
   return impl->texture;
 }
 
+const DmabufAttributes* WaylandSurface::GetDmabufAttributes() {
+  std::shared_ptr<Impl> impl = impl_.lock();
+  if (!impl || !impl->held_buffer || !impl->held_buffer->buffer) {
+    return nullptr;
+  }
+  return WaylandLinuxDmabuf::GetAttributes(impl->held_buffer->buffer);
+}
+
+wl_resource* WaylandSurface::GetDmabufBuffer() {
+  std::shared_ptr<Impl> impl = impl_.lock();
+  if (!impl || !impl->held_buffer || !impl->held_buffer->buffer ||
+      !WaylandLinuxDmabuf::GetAttributes(impl->held_buffer->buffer)) {
+    return nullptr;
+  }
+  return impl->held_buffer->buffer;
+}
+
+void WaylandSurface::AddPresentationFeedback(WaylandResource feedback) {
+  std::shared_ptr<Impl> impl = impl_.lock();
+  if (!impl) {
+    WaylandPresentation::SendDiscarded(feedback);
+    return;
+  }
+  impl->pending_feedbacks.push_back(feedback);
+}
+
+void WaylandSurface::LatchPresentationFeedbacks() {
+  for (auto& committed : Impl::committed_feedbacks) {
+    // The content updates of hidden surfaces never reach the screen.
+    if (committed.second->visible) {
+      Impl::latched_feedbacks.push_back(committed.first);
+    } else {
+      WaylandPresentation::SendDiscarded(committed.first);
+    }
+  }
+  Impl::committed_feedbacks.clear();
+}
+
+void WaylandSurface::SendPresentationFeedbacks(const FrameClock& clock,
+                                               bool zero_copy) {
+  for (auto feedback : Impl::latched_feedbacks) {
+    WaylandPresentation::SendPresented(feedback, clock, zero_copy);
+  }
+  Impl::latched_feedbacks.clear();
+}
+
+void WaylandSurface::OnFrameSubmitted() {
+  Impl::submitted_frames++;
+}
+
+void WaylandSurface::ReleaseRetiredBuffers() {
+  // All the submitted frames are presented, so the buffers which were
+  // replaced before the last one was submitted are no longer on the screen.
+  auto& retired = Impl::retired_buffers;
+  retired.erase(
+      std::remove_if(retired.begin(), retired.end(),
+                     [](const auto& buffer) {
+                       return buffer.second <= Impl::submitted_frames;
+                     }),
+      retired.end());
+}
+
+Region WaylandSurface::TakeDamage() {
+  std::shared_ptr<Impl> impl = impl_.lock();
+  if (!impl) {
+    return Region();
+  }
+
+  Region damage;
+  std::swap(damage, impl->damage);
+  damage.Intersect(Rect<int>(0, 0, impl->size.X(), impl->size.Y()));
+  return damage;
+}
+
 std::weak_ptr<WaylandBindingHandlerDelegate> WaylandSurface::InputInterface() {
   return impl_;
 }
@@ -9,7 +9,10 @@
 
 #include <chrono>
 
+#include "waffle/backend/surface/dmabuf_attributes.h"
+#include "waffle/backend/window/frame_clock.h"
 #include "waffle/renderer/texture.h"
+#include "waffle/utils/region.h"
 #include "waffle/wayland/wayland_binding_handler_delegate.h"
 #include "waffle/wayland/wayland_resource.h"
 
@@ -25,17 +28,77 @@ class WaylandSurface {
 
   Texture GetTexture();
 
+  // Returns the attributes of the current buffer if it's a dmabuf buffer.
+  // Otherwise, returns nullptr.
+  const DmabufAttributes* GetDmabufAttributes();
+
+  // Returns the current buffer if it's a dmabuf buffer. Otherwise, returns
+  // nullptr.
+  wl_resource* GetDmabufBuffer();
+
+  // Returns the damaged area committed since the last call, in surface local
+  // coordinates.
+  Region TakeDamage();
+
+  // Adds a wp_presentation_feedback for the next content update.
+  void AddPresentationFeedback(WaylandResource feedback);
+
   static WaylandSurface GetSurfaceFrom(WaylandResource resource);
 
-  static void HandleFrameCallbacks();
+  // Whether the surface is in the scene, i.e. it has a shell role. Only
+  // mapped surfaces can be hidden. The others, e.g. cursor surfaces, get
+  // their frame callbacks in every frame.
+  void SetMapped(bool mapped);
 
- private:
-  static int TimeSinceProgramStartMillisecond();
+  // Whether the surface is shown on the output. This is updated by the
+  // compositor in every frame.
+  void SetVisible(bool visible);
+
+  // Returns true if |pos| in surface local coordinates is in the surface and
+  // its input region.
+  bool AcceptsInput(Vec2<double> pos);
+
+  // Returns the area where the surface has no translucent pixels, in surface
+  // local coordinates. It's the whole surface if the buffer format has no
+  // alpha channel.
+  Region OpaqueRegion();
+
+  // Sends wl_surface.frame callbacks of the visible surfaces and the ones
+  // which aren't mapped.
+  static void HandleFrameCallbacks(FrameClock::Clock::time_point now);
 
+  // Sends wl_surface.frame callbacks of the mapped surfaces which are hidden,
+  // e.g. occluded by other windows, at most once per |interval|. They are
+  // withheld if |interval| is zero. Returns the time when the next withheld
+  // callback is due, or
+  // FrameClock::Clock::time_point::max() if there is none.
+  static FrameClock::Clock::time_point HandleHiddenFrameCallbacks(
+      FrameClock::Clock::time_point now,
+      std::chrono::nanoseconds interval);
+
+  // Takes the feedbacks of the content updates committed so far. This needs
+  // to be called when a frame is submitted. The feedbacks of the surfaces
+  // which aren't visible in the frame are discarded.
+  static void LatchPresentationFeedbacks();
+
+  // Sends the latched feedbacks with the last presentation of |clock|.
+  // |zero_copy| tells that the frame was a client buffer scanned out directly.
+  static void SendPresentationFeedbacks(const FrameClock& clock,
+                                        bool zero_copy);
+
+  // Counts a frame submitted to the backend, either composited or scanned
+  // out. Buffers replaced after this are still on the screen until the next
+  // frame is presented.
+  static void OnFrameSubmitted();
+
+  // Releases the buffers which were replaced by newer ones and are no longer
+  // on the screen. This needs to be called after the last submitted frame is
+  // presented.
+  static void ReleaseRetiredBuffers();
+
+ private:
   struct Impl;
   std::weak_ptr<Impl> impl_;
-
-  static std::chrono::high_resolution_clock::time_point program_start_time_;
 };
 
 }  // namespace waffle
@@ -23,6 +23,13 @@ struct XdgShellSurface::Impl : WaylandResource::Data, WaylandBindingHandler {
   WaylandResource xdg_surface_resource;
   WaylandResource xdg_top_level_resource;
 
+  SceneNode scene_node{SceneNode::Type::kToplevel, this};
+
+  ~Impl() {
+    waffle::Compositor::Instance()->RemoveWindow(&scene_node);
+    wayland_surface.SetMapped(false);
+  }
+
   static const struct zxdg_surface_v6_interface xdg_surface_v6_interface;
   static const struct zxdg_toplevel_v6_interface xdg_top_level_v6_interface;
 
@@ -35,6 +42,31 @@ struct XdgShellSurface::Impl : WaylandResource::Data, WaylandBindingHandler {
   std::weak_ptr<WaylandBindingHandlerDelegate> InputInterface() {
     return wayland_surface.InputInterface();
   }
+
+  // |WaylandBindingHandler|
+  Region TakeDamage() { return wayland_surface.TakeDamage(); }
+
+  // |WaylandBindingHandler|
+  Texture GetTexture() { return wayland_surface.GetTexture(); }
+
+  // |WaylandBindingHandler|
+  const DmabufAttributes* GetDmabufAttributes() {
+    return wayland_surface.GetDmabufAttributes();
+  }
+
+  // |WaylandBindingHandler|
+  wl_resource* GetDmabufBuffer() { return wayland_surface.GetDmabufBuffer(); }
+
+  // |WaylandBindingHandler|
+  Region OpaqueRegion() { return wayland_surface.OpaqueRegion(); }
+
+  // |WaylandBindingHandler|
+  bool AcceptsInput(Vec2<double> pos) {
+    return wayland_surface.AcceptsInput(pos);
+  }
+
+  // |WaylandBindingHandler|
+  void SetVisible(bool visible) { wayland_surface.SetVisible(visible); }
 };
 
 const struct zxdg_surface_v6_interface
@@ -201,10 +233,10 @@ XdgShellSurface::XdgShellSurface(wl_client* client,
   WAFFLE_LOG(TRACE) << "Creating XdgShellSurface...";
 
   auto impl = std::make_shared<Impl>();
-  waffle::Compositor::Instance()->AddWindow(impl);
+  waffle::Compositor::Instance()->AddWindow(&impl->scene_node);
 
   impl->wayland_surface = surface;
-  impl->SetTexture(surface.GetTexture());
+  impl->wayland_surface.SetMapped(true);
   impl->xdg_surface_resource.Create(impl, client, id,
                                     &zxdg_surface_v6_interface, version,
                                     &Impl::xdg_surface_v6_interface);
@@ -8,7 +8,10 @@
 
 #include "waffle/logger.h"
 #include "waffle/wayland/wayland_data_device_manager.h"
+#include "waffle/wayland/wayland_linux_dmabuf.h"
+#include "waffle/wayland/wayland_presentation.h"
 #include "waffle/wayland/wayland_region.h"
+#include "waffle/wayland/wayland_relative_pointer.h"
 #include "waffle/wayland/wayland_resource.h"
 #include "waffle/wayland/wayland_seat.h"
 #include "waffle/wayland/wayland_shell_surface.h"
@@ -120,8 +123,24 @@ WaylandServer::WaylandServer() {
                    &WaylandServer::DataDeviceManager);
   wl_global_create(display_, &wl_output_interface, kWlOutputMaxVersion, nullptr,
                    &WaylandServer::Output);
+  wl_global_create(display_, &zwp_linux_dmabuf_v1_interface,
+                   kZwpLinuxDmabufV1MaxVersion, nullptr,
+                   &WaylandServer::LinuxDmabuf);
 
+  wl_global_create(display_, &wp_presentation_interface,
+                   kWpPresentationMaxVersion, nullptr,
+                   &WaylandServer::Presentation);
+
+  wl_global_create(display_, &zwp_relative_pointer_manager_v1_interface,
+                   kZwpRelativePointerManagerV1MaxVersion, nullptr,
+                   &WaylandServer::RelativePointerManager);
+
+  // ARGB8888 and XRGB8888 are always supported. YUV buffers are converted
+  // by the renderer.
   wl_display_init_shm(display_);
+  wl_display_add_shm_format(display_, WL_SHM_FORMAT_NV12);
+  wl_display_add_shm_format(display_, WL_SHM_FORMAT_YUV420);
+  wl_display_add_shm_format(display_, WL_SHM_FORMAT_YUYV);
   event_loop_ = wl_display_get_event_loop(display_);
 }
 
@@ -224,10 +243,40 @@ void WaylandServer::Output(wl_client* client,
   }
 }
 
+void WaylandServer::LinuxDmabuf(wl_client* client,
+                                void* data,
+                                uint32_t version,
+                                uint32_t id) {
+  WAFFLE_LOG(TRACE) << "Server::LinuxDmabuf is called.";
+  assert(version <= kZwpLinuxDmabufV1MaxVersion);
+
+  WaylandLinuxDmabuf(client, id, version);
+}
+
+void WaylandServer::Presentation(wl_client* client,
+                                 void* data,
+                                 uint32_t version,
+                                 uint32_t id) {
+  WAFFLE_LOG(TRACE) << "Server::Presentation is called.";
+  assert(version <= kWpPresentationMaxVersion);
+
+  WaylandPresentation(client, id, version);
+}
+
+void WaylandServer::RelativePointerManager(wl_client* client,
+                                           void* data,
+                                           uint32_t version,
+                                           uint32_t id) {
+  WAFFLE_LOG(TRACE) << "Server::RelativePointerManager is called.";
+  assert(version <= kZwpRelativePointerManagerV1MaxVersion);
+
+  WaylandRelativePointerManager(client, id, version);
+}
+
 void WaylandServer::HandleEvent() {
-  wl_event_loop_dispatch(event_loop_, 0);
   wl_display_flush_clients(display_);
-  WaylandSurface::HandleFrameCallbacks();
+  constexpr int kWaitForever = -1;
+  wl_event_loop_dispatch(event_loop_, kWaitForever);
 }
 
 }  // namespace waffle
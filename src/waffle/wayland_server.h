@@ -7,6 +7,9 @@
 
 #include <wayland-server-protocol.h>
 #include <wayland-server.h>
+#include <wayland/protocols/linux-dmabuf-unstable-v1-server-protocol.h>
+#include <wayland/protocols/presentation-time-server-protocol.h>
+#include <wayland/protocols/relative-pointer-unstable-v1-server-protocol.h>
 #include <wayland/protocols/xdg-shell-server-protocol.h>
 
 namespace waffle {
@@ -40,8 +43,27 @@ class WaylandServer {
                      void* data,
                      uint32_t version,
                      uint32_t id);
+  static void LinuxDmabuf(wl_client* client,
+                          void* data,
+                          uint32_t version,
+                          uint32_t id);
+
+  static void Presentation(wl_client* client,
+                           void* data,
+                           uint32_t version,
+                           uint32_t id);
+
+  static void RelativePointerManager(wl_client* client,
+                                     void* data,
+                                     uint32_t version,
+                                     uint32_t id);
   static uint32_t SerialNumber() { return ++serial_num_; }
   wl_display* Display() { return display_; }
+
+  // Flushes the events to the clients, and then waits for the next event
+  // source to become ready and dispatches it. All the sources of the
+  // compositor, e.g. the backend's inputs and the repaint timer, are in the
+  // same loop.
   void HandleEvent();
 
  private: